@@ -0,0 +1,72 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <string>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "kls/Handle.h"
+
+using namespace kls;
+
+namespace {
+    struct Close {
+        void operator()(int &) const noexcept {}
+    };
+
+    template<class Counting>
+    struct IntHandle : Handle<int, Counting> {
+        using Handle<int, Counting>::Handle;
+    };
+
+    constexpr int copies = 2000000;
+
+    // every thread copies and drops one shared handle, the owner of a biased count is the creating thread
+    template<class Counting>
+    void run(const char *name, unsigned threads) {
+        using H = IntHandle<Counting>;
+        SafeHandle<H> shared(H(Close{}, 1));
+        { auto promote = shared; }
+        const auto time = bench::seconds([&] {
+            const auto body = [&shared] {
+                for (int i = 0; i < copies; ++i) {
+                    auto copy = shared;
+                    bench::keep(copy);
+                }
+            };
+            std::vector<std::thread> others;
+            for (unsigned i = 1; i < threads; ++i) others.emplace_back(body);
+            body();
+            for (auto &t: others) t.join();
+        }, 3);
+        const auto label = std::string(name) + ", " + std::to_string(threads) + " thread(s)";
+        bench::report(label.c_str(), time * 1e9 / copies, "ns/copy on each thread");
+    }
+}
+
+int main() {
+    run<LocalHandleCount>("LocalHandleCount", 1);
+    for (const unsigned threads: {1u, 2u, 4u, 8u}) {
+        run<AtomicHandleCount>("AtomicHandleCount", threads);
+        run<BiasedHandleCount>("BiasedHandleCount", threads);
+    }
+}
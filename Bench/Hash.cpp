@@ -0,0 +1,67 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <string>
+#include <vector>
+#include "Bench.h"
+#include "kls/Hash.h"
+#include "kls/Simd.h"
+
+using namespace kls;
+
+namespace {
+    constexpr simd::Level levels[] = {simd::Level::Scalar, simd::Level::SSE2, simd::Level::AVX2, simd::Level::AVX512};
+    constexpr const char *level_names[] = {"scalar", "sse2", "avx2", "avx512"};
+
+    // hashes about 256MiB in total per round, as many inputs of the given size
+    template<class Fn>
+    void run(const std::string &name, const std::vector<unsigned char> &data, size_t size, Fn &&fn) {
+        const auto repeats = (size_t(256) << 20) / size;
+        const auto time = bench::seconds([&] {
+            uint64_t sink = 0;
+            for (size_t i = 0; i < repeats; ++i) sink += fn(Span<>(data.data() + i % 64, size));
+            bench::keep(sink);
+        }, 3);
+        const auto label = name + ", " + std::to_string(size) + " bytes";
+        bench::report(label.c_str(), double(repeats * size) / time / 1e9, "GB/s");
+    }
+}
+
+int main() {
+    std::vector<unsigned char> data((size_t(256) << 10) + 64);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<unsigned char>(i * 131 + 7);
+    for (size_t i = 0; i < std::size(levels); ++i) {
+        if (simd::set_level(levels[i]) != levels[i]) continue;
+        const std::string level = level_names[i];
+        for (const size_t size: {size_t(16), size_t(64), size_t(1) << 10, size_t(256) << 10}) {
+            run("crc32c " + level, data, size, [](Span<> s) { return hash::crc32c(s); });
+            run("hash64 " + level, data, size, [](Span<> s) { return hash::hash64(s); });
+        }
+        // streaming in the 4KiB pieces a writer would hand over
+        run("Hasher64 " + level + " in 4KiB updates", data, size_t(256) << 10, [](Span<> s) {
+            hash::Hasher64 hasher{};
+            for (size_t at = 0; at < s.size(); at += 4096)
+                hasher.update(Span<>(static_cast<const char *>(s.data()) + at, 4096));
+            return hasher.digest();
+        });
+    }
+}
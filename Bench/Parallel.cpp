@@ -0,0 +1,62 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <thread>
+#include <numeric>
+#include "Bench.h"
+#include "kls/Parallel.h"
+
+using namespace kls;
+
+namespace {
+    constexpr size_t items = size_t(16) << 20;
+
+    void report(const char *name, size_t threads, double seconds, double bytes) {
+        const auto label = std::string(name) + ", " + std::to_string(threads) + " thread(s)";
+        bench::report(label.c_str(), bytes / seconds / 1e9, "GB/s");
+    }
+}
+
+int main() {
+    std::vector<float> source(items), target(items);
+    std::iota(source.begin(), source.end(), 0.0f);
+    const Span<float> src(source), dst(target);
+    std::printf("%zu MiB of floats on %u hardware threads\n", items * sizeof(float) >> 20,
+                std::thread::hardware_concurrency());
+    for (const size_t requested: {1, 2, 4, 8, 16, 32}) {
+        const auto threads = parallel::set_concurrency(requested);
+        const auto bytes = double(items * sizeof(float));
+        report("copy", threads, bench::seconds([&] { parallel::copy(src, dst); }), 2 * bytes);
+        report("transform sqrt", threads, bench::seconds([&] {
+            parallel::transform(src, dst, [](float x) { return std::sqrt(x); });
+        }), 2 * bytes);
+        report("for_each", threads, bench::seconds([&] {
+            parallel::for_each(dst, [](float &x) { x = x * 0.5f + 1.0f; });
+        }), 2 * bytes);
+        report("reduce", threads, bench::seconds([&] {
+            bench::keep(parallel::reduce(src, 0.0, [](double a, double b) { return a + b; }));
+        }), bytes);
+    }
+}
@@ -0,0 +1,90 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <latch>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include "Bench.h"
+#include "kls/STL.h"
+#include "kls/pmr/Pool.h"
+#include "kls/pmr/Allocator.h"
+#include "kls/temp/Temp.h"
+#include "kls/hal/Processor.h"
+
+using namespace kls;
+
+namespace {
+    template<class T>
+    using Alloc = pmr::PolymorphicAllocator<T>;
+    using Map = AllocAliased<Alloc>::map<int, int>;
+
+    // resident set size, or 0 where it is not read
+    long resident_kib() {
+#ifdef __linux__
+        std::ifstream status("/proc/self/status");
+        for (std::string line; std::getline(status, line);)
+            if (line.rfind("VmRSS:", 0) == 0) return std::stol(line.substr(6));
+#endif
+        return 0;
+    }
+
+    // every thread churns a small map and then stays alive with its caches filled until all threads have been
+    // measured, as idle threads of an oversubscribed process would
+    void run(const char *name, pmr::MemoryResource *resource, unsigned threads) {
+        std::latch ready{ptrdiff_t(threads)}, release{1};
+        const auto before = resident_kib();
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (unsigned i = 0; i < threads; ++i) {
+            workers.emplace_back([&] {
+                Map map{Alloc<int>(resource)};
+                for (int round = 0; round < 5; ++round) {
+                    for (int key = 0; key < 5000; ++key) map.emplace(key, key);
+                    for (int key = 0; key < 5000; ++key) map.erase(key);
+                }
+                ready.count_down();
+                release.wait();
+            });
+        }
+        ready.wait();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        const auto held = resident_kib() - before;
+        release.count_down();
+        for (auto &t: workers) t.join();
+        bench::report((std::string(name) + ", time").c_str(), elapsed.count() * 1e3, "ms");
+        if (held) bench::report((std::string(name) + ", resident growth").c_str(), double(held), "KiB");
+    }
+}
+
+// both pools share one depot and the second run would reuse the blocks of the first, so the resident growth is only
+// comparable between processes, pass per-processor, thread or temp to measure one resource per run
+int main(int argc, char **argv) {
+    const std::string only = argc > 1 ? argv[1] : "";
+    const auto threads = 10 * hal::processor::count();
+    std::printf("%u threads on %u processors\n", threads, hal::processor::count());
+    if (only.empty() || only == "per-processor")
+        run("per_processor_pool_resource", pmr::per_processor_pool_resource(), threads);
+    if (only.empty() || only == "thread") run("pool_resource (thread caches)", pmr::pool_resource(), threads);
+    if (only.empty() || only == "temp") run("temp::resource (thread blocks)", temp::resource(), threads);
+}
@@ -0,0 +1,65 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <string>
+#include "Bench.h"
+#include "kls/STL.h"
+#include "kls/pmr/Pool.h"
+#include "kls/pmr/Allocator.h"
+
+using namespace kls;
+
+namespace {
+    template<class T>
+    using Alloc = pmr::PolymorphicAllocator<T>;
+    using Map = AllocAliased<Alloc>::map<int, int>;
+    using Set = AllocAliased<Alloc>::set<int>;
+
+    constexpr int keys = 100000;
+
+    // inserts in a scattered order and erases in key order, so freed nodes are not reused in allocation order
+    template<class Container, class Insert>
+    void insert_erase(pmr::MemoryResource *resource, Insert insert) {
+        Container container{Alloc<int>(resource)};
+        for (int i = 0; i < keys; ++i) insert(container, int(i * 7919ll % keys));
+        for (int i = 0; i < keys; ++i) container.erase(i);
+        bench::keep(container);
+    }
+
+    void run(const char *name, pmr::MemoryResource *resource) {
+        const auto map = bench::seconds([&] {
+            insert_erase<Map>(resource, [](Map &m, int key) { m.emplace(key, key); });
+        });
+        const auto set = bench::seconds([&] {
+            insert_erase<Set>(resource, [](Set &s, int key) { s.insert(key); });
+        });
+        bench::report((std::string("map insert+erase, ") + name).c_str(), map * 1e9 / keys, "ns/key");
+        bench::report((std::string("set insert+erase, ") + name).c_str(), set * 1e9 / keys, "ns/key");
+    }
+}
+
+int main() {
+    run("default_resource", pmr::default_resource());
+    run("pool_resource", pmr::pool_resource());
+    pmr::UnsynchronizedPoolResource unsynchronized{};
+    run("UnsynchronizedPoolResource", &unsynchronized);
+}
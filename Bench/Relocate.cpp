@@ -0,0 +1,75 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <memory>
+#include <vector>
+#include "Bench.h"
+#include "kls/pmr/Vector.h"
+#include "kls/pmr/Automatic.h"
+
+using namespace kls;
+
+namespace {
+    // the same layout as unique_ptr without the relocation opt-in, so relocate takes the element-wise path
+    struct Owner {
+        std::unique_ptr<int> p;
+    };
+
+    static_assert(is_trivially_relocatable_v<std::unique_ptr<int>> && !is_trivially_relocatable_v<Owner>);
+
+    constexpr size_t items = 1 << 16;
+
+    template<class T>
+    double relocate_items() {
+        std::allocator<T> alloc{};
+        auto from = alloc.allocate(items), to = alloc.allocate(items);
+        std::uninitialized_value_construct_n(from, items);
+        const auto time = bench::seconds([&] {
+            for (int i = 0; i < 100; ++i) {
+                relocate(Span<T>(from, items), Span<T>(to, items));
+                std::swap(from, to);
+            }
+            bench::keep(from);
+        });
+        std::destroy_n(from, items);
+        alloc.deallocate(from, items);
+        alloc.deallocate(to, items);
+        return time * 1e9 / (100.0 * items);
+    }
+
+    template<class Container>
+    double grow() {
+        return bench::seconds([] {
+            Container container;
+            for (size_t i = 0; i < items; ++i) container.emplace_back();
+            bench::keep(container);
+        }) * 1e9 / items;
+    }
+}
+
+int main() {
+    bench::report("relocate unique_ptr (memmove)", relocate_items<std::unique_ptr<int>>(), "ns/item");
+    bench::report("relocate Owner (element-wise)", relocate_items<Owner>(), "ns/item");
+    bench::report("pmr::Vector<unique_ptr> emplace_back", grow<pmr::Vector<std::unique_ptr<int>>>(), "ns/item");
+    bench::report("pmr::Vector<Owner> emplace_back", grow<pmr::Vector<Owner>>(), "ns/item");
+    bench::report("std::vector<unique_ptr> emplace_back", grow<std::vector<std::unique_ptr<int>>>(), "ns/item");
+}
@@ -0,0 +1,134 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Replaces the global operator new and delete with the thread-caching size-class pool of kls.essential
+// This file is only built into the opt-in kls.essential.malloc object library
+
+#include <new>
+#include <cstdlib>
+#include "kls/pmr/Pool.h"
+#include "kls/essential/Memory.h"
+
+namespace {
+    using namespace kls::pmr::detail::pool;
+
+    void *fallback_allocate(size_t bytes, size_t align) noexcept {
+        if (align <= alignof(std::max_align_t)) return std::malloc(bytes ? bytes : 1);
+#ifdef _MSC_VER
+        return _aligned_malloc(bytes ? bytes : 1, align);
+#else
+        return std::aligned_alloc(align, (bytes + align - 1) & ~(align - 1));
+#endif
+    }
+
+    void fallback_deallocate(void *p, [[maybe_unused]] size_t align) noexcept {
+#ifdef _MSC_VER
+        if (align > alignof(std::max_align_t)) return _aligned_free(p);
+#endif
+        std::free(p);
+    }
+
+    // pooled sizes go to the C heap as well once the block host runs out of address space
+    void *try_allocate(size_t bytes, size_t align) noexcept {
+        if (pooled(bytes, align)) {
+            if (const auto p = allocate(class_of(bytes)); p) return p;
+        }
+        return fallback_allocate(bytes, align);
+    }
+
+    bool from_pool(void *p) noexcept { return kls::essential::is_4m_block_address(reinterpret_cast<uintptr_t>(p)); }
+
+    void *allocate_or_throw(size_t bytes, size_t align) {
+        for (;;) {
+            if (const auto p = try_allocate(bytes, align); p) return p;
+            if (const auto handler = std::get_new_handler(); handler) handler(); else throw std::bad_alloc();
+        }
+    }
+
+    void *allocate_or_null(size_t bytes, size_t align) noexcept {
+        try { return allocate_or_throw(bytes, align); } catch (...) { return nullptr; }
+    }
+
+    void release(void *p, size_t align) noexcept {
+        if (!p) return;
+        if (from_pool(p)) return deallocate(p, class_of_pointer(p));
+        fallback_deallocate(p, align);
+    }
+
+    void release_sized(void *p, size_t bytes, size_t align) noexcept {
+        if (!p) return;
+        if (pooled(bytes, align) && from_pool(p)) return deallocate(p, class_of(bytes));
+        fallback_deallocate(p, align);
+    }
+
+    constexpr size_t default_align = alignof(std::max_align_t);
+}
+
+void *operator new(size_t bytes) { return allocate_or_throw(bytes, default_align); }
+
+void *operator new[](size_t bytes) { return allocate_or_throw(bytes, default_align); }
+
+void *operator new(size_t bytes, const std::nothrow_t &) noexcept { return allocate_or_null(bytes, default_align); }
+
+void *operator new[](size_t bytes, const std::nothrow_t &) noexcept { return allocate_or_null(bytes, default_align); }
+
+void *operator new(size_t bytes, std::align_val_t align) { return allocate_or_throw(bytes, size_t(align)); }
+
+void *operator new[](size_t bytes, std::align_val_t align) { return allocate_or_throw(bytes, size_t(align)); }
+
+void *operator new(size_t bytes, std::align_val_t align, const std::nothrow_t &) noexcept {
+    return allocate_or_null(bytes, size_t(align));
+}
+
+void *operator new[](size_t bytes, std::align_val_t align, const std::nothrow_t &) noexcept {
+    return allocate_or_null(bytes, size_t(align));
+}
+
+void operator delete(void *p) noexcept { release(p, default_align); }
+
+void operator delete[](void *p) noexcept { release(p, default_align); }
+
+void operator delete(void *p, const std::nothrow_t &) noexcept { release(p, default_align); }
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept { release(p, default_align); }
+
+void operator delete(void *p, size_t bytes) noexcept { release_sized(p, bytes, default_align); }
+
+void operator delete[](void *p, size_t bytes) noexcept { release_sized(p, bytes, default_align); }
+
+void operator delete(void *p, std::align_val_t align) noexcept { release(p, size_t(align)); }
+
+void operator delete[](void *p, std::align_val_t align) noexcept { release(p, size_t(align)); }
+
+void operator delete(void *p, size_t bytes, std::align_val_t align) noexcept {
+    release_sized(p, bytes, size_t(align));
+}
+
+void operator delete[](void *p, size_t bytes, std::align_val_t align) noexcept {
+    release_sized(p, bytes, size_t(align));
+}
+
+void operator delete(void *p, std::align_val_t align, const std::nothrow_t &) noexcept { release(p, size_t(align)); }
+
+void operator delete[](void *p, std::align_val_t align, const std::nothrow_t &) noexcept {
+    release(p, size_t(align));
+}
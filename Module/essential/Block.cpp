@@ -21,7 +21,6 @@
 */
 
 #include <mutex>
-#include <cstring>
 #include "kls/hal/System.h"
 #include "kls/essential/Memory.h"
 #include "kls/essential/MemoryAVL.h"
@@ -38,14 +37,13 @@ namespace {
 #endif
         }
 
-        void commit(const uint32_t block) const noexcept {
+        [[nodiscard]] bool commit(const uint32_t block) const noexcept {
 #ifdef KLS_SYS_NTOS
-            VirtualAlloc(reinterpret_cast<LPVOID>(compute_base(block)), g_block_size, MEM_COMMIT, PAGE_READWRITE);
+            const auto address = reinterpret_cast<LPVOID>(compute_base(block));
+            return VirtualAlloc(address, g_block_size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
 #else
-            if (mprotect(reinterpret_cast<void *>(compute_base(block)), g_block_size, PROT_READ | PROT_WRITE) == -1) {
-                puts(strerror(errno));
-                fflush(stdout);
-            }
+            const auto address = reinterpret_cast<void *>(compute_base(block));
+            return mprotect(address, g_block_size, PROT_READ | PROT_WRITE) == 0;
 #endif
         }
 
@@ -60,14 +58,17 @@ namespace {
 
     public:
         block_host() noexcept
-                : m_base_address(reinterpret_cast<uintptr_t>(reserve())),
-                  m_start_address(block_align(m_base_address)), m_brk(0u), m_alloc(0u) {}
+                : m_base_address(reserved_base()), m_start_address(block_align(m_base_address)),
+                  m_capacity(m_base_address ? uint32_t((m_base_address + g_reserved_address_space - m_start_address) >>
+                                                       g_block_size_shl) : 0u), m_brk(0u), m_alloc(0u) {}
 
         // we do not need to cleanup anything as the OS will release them all on process termination
 
+        // 0 once every block of the reserved address space is rented or committing one fails
         uintptr_t rent() noexcept {
             const std::lock_guard lock(m_lock);
-            return compute_base(alloc_id());
+            const auto id = alloc_id();
+            return id == g_no_block ? 0 : compute_base(id);
         }
 
         void free(uintptr_t ptr) noexcept {
@@ -75,6 +76,10 @@ namespace {
             release_id((ptr - m_start_address) >> g_block_size_shl);
         }
 
+        [[nodiscard]] bool contains(uintptr_t ptr) const noexcept {
+            return m_capacity && ptr >= m_start_address && ptr < m_base_address + g_reserved_address_space;
+        }
+
         static block_host &instance() noexcept {
             static block_host instance{};
             return instance;
@@ -83,11 +88,23 @@ namespace {
     private:
         const uintptr_t m_base_address;
         const uintptr_t m_start_address;
+        const uint32_t m_capacity;
         uint32_t m_brk, m_alloc;
         std::mutex m_lock;
         static constexpr uintptr_t g_block_size_shl = 22ull;
         static constexpr uintptr_t g_block_size = 1ull << g_block_size_shl;
         static constexpr uintptr_t g_reserved_address_space = 4ull << 28ull;
+        static constexpr uint32_t g_no_block = UINT32_MAX;
+
+        // 0 if the address space could not be reserved
+        static uintptr_t reserved_base() noexcept {
+            const auto base = reserve();
+#ifdef KLS_SYS_NTOS
+            return reinterpret_cast<uintptr_t>(base);
+#else
+            return base == MAP_FAILED ? 0 : reinterpret_cast<uintptr_t>(base);
+#endif
+        }
 
         // basic alignment computation
         [[nodiscard]] uintptr_t compute_base(const uint32_t block) const noexcept {
@@ -104,7 +121,10 @@ namespace {
         uint32_t alloc_id() noexcept {
             if (const auto extract = m_holes.pop_front(); extract)
                 return (extract - m_start_address) >> g_block_size_shl;
-            if (m_brk == m_alloc) commit(m_alloc++);
+            if (m_brk == m_alloc) {
+                if (m_alloc == m_capacity || !commit(m_alloc)) return g_no_block;
+                ++m_alloc;
+            }
             return m_brk++;
         }
 
@@ -122,4 +142,6 @@ namespace kls::essential {
     uintptr_t rent_4m_block() noexcept { return block_host::instance().rent(); }
 
     void return_4m_block(uintptr_t block) noexcept { return block_host::instance().free(block); }
+
+    bool is_4m_block_address(uintptr_t address) noexcept { return block_host::instance().contains(address); }
 }
@@ -0,0 +1,262 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <memory>
+#include "kls/Epoch.h"
+#include "kls/pmr/Pool.h"
+
+namespace kls::detail {
+    struct EpochBatch {
+        static constexpr size_t capacity = 64;
+
+        struct Entry {
+            void *object;
+            void (*reclaim)(void *object) noexcept;
+        };
+
+        EpochBatch *next{};
+        uint64_t epoch{};
+        size_t count{};
+        Entry entries[capacity];
+
+        static EpochBatch *make() {
+            const auto memory = pmr::pool_resource()->allocate(sizeof(EpochBatch), alignof(EpochBatch));
+            return std::construct_at(static_cast<EpochBatch *>(memory));
+        }
+
+        // runs the reclaimers and frees the batch
+        static size_t drop(EpochBatch *batch) noexcept {
+            const auto count = batch->count;
+            for (size_t i = 0; i < count; ++i) batch->entries[i].reclaim(batch->entries[i].object);
+            pmr::pool_resource()->deallocate(batch, sizeof(EpochBatch), alignof(EpochBatch));
+            return count;
+        }
+    };
+
+    // one per thread and domain, records are recycled but never unlinked while the domain lives
+    struct alignas(64) EpochRecord {
+        // the pinned epoch shifted left by one with the lowest bit set, zero while not pinned
+        std::atomic<uint64_t> epoch{0};
+        std::atomic_bool used{true};
+        // used by a thread that has already exited, released as soon as it is unpinned
+        bool transient{};
+        uint32_t depth{};
+        EpochDomain *domain;
+        EpochRecord *next{};
+        EpochRecord *thread_next{};
+        EpochBatch *open{};
+        // sealed batches, oldest first
+        EpochBatch *oldest{};
+        EpochBatch *newest{};
+
+        explicit EpochRecord(EpochDomain *domain) noexcept: domain(domain) {}
+    };
+}
+
+namespace {
+    using kls::detail::EpochBatch;
+    using kls::detail::EpochRecord;
+
+    constinit thread_local EpochRecord *t_records = nullptr;
+    constinit thread_local bool t_exited = false;
+
+    size_t drop_all(EpochBatch *it) noexcept {
+        size_t count = 0;
+        while (it) count += EpochBatch::drop(std::exchange(it, it->next));
+        return count;
+    }
+}
+
+namespace kls {
+    EpochDomain::~EpochDomain() {
+        // reclaimers may retire again, keep flushing until nothing is left
+        for (;;) {
+            for (auto it = mRecords.load(std::memory_order_acquire); it; it = it->next) {
+                seal(it);
+                if (it->oldest) share(it->oldest, it->newest);
+                it->oldest = it->newest = nullptr;
+            }
+            const auto shared = mShared.exchange(nullptr, std::memory_order_acquire);
+            if (!shared) break;
+            drop_all(shared);
+        }
+        for (auto it = &t_records; *it;) {
+            if ((*it)->domain == this) *it = (*it)->thread_next; else it = &(*it)->thread_next;
+        }
+        for (auto it = mRecords.load(std::memory_order_acquire); it;) delete std::exchange(it, it->next);
+    }
+
+    EpochDomain::Guard EpochDomain::pin() {
+        const auto record = local();
+        if (record->depth++ == 0) {
+            // full barrier, the pointers read after this must not be loaded before the pin is visible
+            record->epoch.exchange(mEpoch.load(std::memory_order_relaxed) << 1 | 1, std::memory_order_seq_cst);
+        }
+        return Guard(record);
+    }
+
+    void EpochDomain::unpin(detail::EpochRecord *record) noexcept {
+        if (--record->depth) return;
+        record->epoch.store(0, std::memory_order_release);
+        if (record->transient) record->domain->release(record);
+    }
+
+    void EpochDomain::retire(void *object, void (*reclaim)(void *object) noexcept) {
+        const auto record = local();
+        try {
+            if (!record->open) record->open = EpochBatch::make();
+        }
+        catch (...) {
+            if (record->transient && !record->depth) release(record);
+            throw;
+        }
+        const auto batch = record->open;
+        batch->entries[batch->count++] = {object, reclaim};
+        if (batch->count == EpochBatch::capacity) {
+            seal(record);
+            this->reclaim(record);
+        }
+        if (record->transient && !record->depth) release(record);
+    }
+
+    void EpochDomain::quiesce() {
+        const auto record = local();
+        seal(record);
+        reclaim(record);
+        if (record->transient && !record->depth) release(record);
+    }
+
+    size_t EpochDomain::collect() noexcept {
+        // a batch needs two advances, try both in one go
+        try_advance();
+        try_advance();
+        const auto safe = mEpoch.load(std::memory_order_acquire);
+        size_t count = 0;
+        EpochBatch *keep = nullptr, *tail = nullptr;
+        for (auto it = mShared.exchange(nullptr, std::memory_order_acquire); it;) {
+            const auto batch = std::exchange(it, it->next);
+            if (batch->epoch + 2 <= safe) {
+                count += EpochBatch::drop(batch);
+                continue;
+            }
+            batch->next = keep;
+            keep = batch;
+            if (!tail) tail = batch;
+        }
+        if (keep) share(keep, tail);
+        return count;
+    }
+
+    EpochDomain &EpochDomain::global() noexcept {
+        static EpochDomain domain{};
+        return domain;
+    }
+
+    detail::EpochRecord *EpochDomain::local() {
+        struct guard {
+            ~guard() noexcept {
+                t_exited = true;
+                for (auto it = std::exchange(t_records, nullptr); it;) {
+                    const auto record = std::exchange(it, it->thread_next);
+                    record->domain->release(record);
+                }
+            }
+        };
+        for (auto it = t_records; it; it = it->thread_next) if (it->domain == this) return it;
+        const auto record = acquire();
+        if (t_exited) {
+            record->transient = true;
+            return record;
+        }
+        static thread_local guard g{};
+        (void) g;
+        record->thread_next = std::exchange(t_records, record);
+        return record;
+    }
+
+    detail::EpochRecord *EpochDomain::acquire() {
+        for (auto it = mRecords.load(std::memory_order_acquire); it; it = it->next) {
+            if (bool expected = false; it->used.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                it->transient = false;
+                it->thread_next = nullptr;
+                return it;
+            }
+        }
+        const auto record = new detail::EpochRecord(this);
+        record->next = mRecords.load(std::memory_order_relaxed);
+        while (!mRecords.compare_exchange_weak(
+                record->next, record, std::memory_order_release, std::memory_order_relaxed
+        ));
+        return record;
+    }
+
+    void EpochDomain::release(detail::EpochRecord *record) noexcept {
+        seal(record);
+        if (record->oldest) share(record->oldest, record->newest);
+        record->oldest = record->newest = nullptr;
+        record->depth = 0;
+        record->epoch.store(0, std::memory_order_release);
+        record->used.store(false, std::memory_order_release);
+    }
+
+    void EpochDomain::seal(detail::EpochRecord *record) noexcept {
+        const auto batch = std::exchange(record->open, nullptr);
+        if (!batch) return;
+        // the stamp has to be read after the objects were unlinked
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        batch->epoch = mEpoch.load(std::memory_order_relaxed);
+        if (record->newest) record->newest->next = batch; else record->oldest = batch;
+        record->newest = batch;
+    }
+
+    void EpochDomain::reclaim(detail::EpochRecord *record) noexcept {
+        if (mDeferred) {
+            if (record->oldest) share(record->oldest, record->newest);
+            record->oldest = record->newest = nullptr;
+            return;
+        }
+        try_advance();
+        const auto safe = mEpoch.load(std::memory_order_acquire);
+        while (record->oldest && record->oldest->epoch + 2 <= safe) {
+            // unlink first, the reclaimers may retire into this record again
+            const auto batch = record->oldest;
+            if (!(record->oldest = batch->next)) record->newest = nullptr;
+            EpochBatch::drop(batch);
+        }
+        if (mShared.load(std::memory_order_relaxed)) collect();
+    }
+
+    void EpochDomain::share(detail::EpochBatch *head, detail::EpochBatch *tail) noexcept {
+        tail->next = mShared.load(std::memory_order_relaxed);
+        while (!mShared.compare_exchange_weak(tail->next, head, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    bool EpochDomain::try_advance() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto epoch = mEpoch.load(std::memory_order_relaxed);
+        for (auto it = mRecords.load(std::memory_order_acquire); it; it = it->next) {
+            const auto pinned = it->epoch.load(std::memory_order_acquire);
+            if ((pinned & 1) && (pinned >> 1) != epoch) return false;
+        }
+        return mEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+    }
+}
@@ -0,0 +1,84 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <mutex>
+#include "kls/Handle.h"
+
+namespace {
+    // threads that can currently take back references released elsewhere
+    struct biased_registry {
+        std::mutex lock{};
+        kls::detail::HandleThread *head{};
+        std::atomic<uint64_t> serial{0};
+
+        static biased_registry &instance() noexcept {
+            static biased_registry registry{};
+            return registry;
+        }
+    };
+}
+
+namespace kls {
+    uint64_t BiasedHandleCount::enroll() noexcept {
+        struct guard {
+            ~guard() noexcept {
+                auto &registry = biased_registry::instance();
+                {
+                    std::lock_guard lk{registry.lock};
+                    for (auto it = &registry.head; *it; it = &(*it)->next) {
+                        if (*it == &tThread) {
+                            *it = tThread.next;
+                            break;
+                        }
+                    }
+                    // blocks created from now on start merged, and the ones left behind get merged by whoever
+                    // releases them next
+                    tThread.id = exited;
+                }
+                drain();
+            }
+        };
+        static thread_local guard g{};
+        (void) g;
+        auto &registry = biased_registry::instance();
+        std::lock_guard lk{registry.lock};
+        tThread.id = registry.serial.fetch_add(1, std::memory_order_relaxed) + 1;
+        tThread.next = std::exchange(registry.head, &tThread);
+        return tThread.id;
+    }
+
+    void BiasedHandleCount::hand_over() noexcept {
+        auto &registry = biased_registry::instance();
+        {
+            std::lock_guard lk{registry.lock};
+            for (auto it = registry.head; it; it = it->next) {
+                if (it->id == mOwner) {
+                    mNext = it->queue.load(std::memory_order_relaxed);
+                    while (!it->queue.compare_exchange_weak(mNext, this, std::memory_order_release));
+                    return;
+                }
+            }
+        }
+        // the owner has exited, so its biased count does not change anymore
+        merge();
+    }
+}
@@ -0,0 +1,208 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#include <system_error>
+#include "kls/essential/MappedFile.h"
+
+#ifndef KLS_SYS_NTOS
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+    int last_error() noexcept {
+#ifdef KLS_SYS_NTOS
+        return int(GetLastError());
+#else
+        return errno;
+#endif
+    }
+
+    [[noreturn]] void fail(const char *what, int error = last_error()) {
+#ifdef KLS_SYS_NTOS
+        throw std::system_error(error, std::system_category(), what);
+#else
+        throw std::system_error(error, std::generic_category(), what);
+#endif
+    }
+
+    // mappings have to start at a multiple of this
+    size_t granularity() noexcept {
+#ifdef KLS_SYS_NTOS
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwAllocationGranularity;
+#else
+        static const auto page = size_t(sysconf(_SC_PAGESIZE));
+        return page;
+#endif
+    }
+
+    size_t page_size() noexcept {
+#ifdef KLS_SYS_NTOS
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return info.dwPageSize;
+#else
+        return granularity();
+#endif
+    }
+}
+
+namespace kls::essential {
+    MappedFile::MappedFile(const std::filesystem::path &path, size_t budget, bool sequential):
+            m_budget(std::max(budget, granularity())), m_sequential(sequential) {
+#ifdef KLS_SYS_NTOS
+        const DWORD flags = sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+        m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) fail("CreateFileW");
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size)) {
+            const auto error = last_error();
+            close();
+            fail("GetFileSizeEx", error);
+        }
+        m_size = size_t(size.QuadPart);
+        if (m_size) {
+            m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!m_mapping) {
+                const auto error = last_error();
+                close();
+                fail("CreateFileMappingW", error);
+            }
+        }
+#else
+        m_file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (m_file < 0) fail("open");
+        struct stat info{};
+        if (fstat(m_file, &info) != 0) {
+            const auto error = last_error();
+            close();
+            fail("fstat", error);
+        }
+        m_size = size_t(info.st_size);
+        if (sequential) posix_fadvise(m_file, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        try {
+            remap(0, 0);
+        } catch (...) {
+            close();
+            throw;
+        }
+    }
+
+    MappedFile::MappedFile(MappedFile &&o) noexcept:
+            m_file(std::exchange(o.m_file, decltype(m_file)(-1))),
+#ifdef KLS_SYS_NTOS
+            m_mapping(std::exchange(o.m_mapping, nullptr)),
+#endif
+            m_window(std::exchange(o.m_window, nullptr)), m_size(std::exchange(o.m_size, 0)),
+            m_budget(o.m_budget), m_window_offset(std::exchange(o.m_window_offset, 0)),
+            m_window_size(std::exchange(o.m_window_size, 0)), m_sequential(o.m_sequential) {}
+
+    MappedFile &MappedFile::operator=(MappedFile &&o) noexcept {
+        if (&o != this) {
+            close();
+            m_file = std::exchange(o.m_file, decltype(m_file)(-1));
+#ifdef KLS_SYS_NTOS
+            m_mapping = std::exchange(o.m_mapping, nullptr);
+#endif
+            m_window = std::exchange(o.m_window, nullptr);
+            m_size = std::exchange(o.m_size, 0);
+            m_budget = o.m_budget;
+            m_window_offset = std::exchange(o.m_window_offset, 0);
+            m_window_size = std::exchange(o.m_window_size, 0);
+            m_sequential = o.m_sequential;
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() noexcept { close(); }
+
+    Span<> MappedFile::map(size_t offset, size_t size) {
+        if (offset > m_size || size > m_size - offset) return {static_cast<void *>(nullptr), size_t(0)};
+        if (offset < m_window_offset || offset + size > m_window_offset + m_window_size) remap(offset, size);
+        return {static_cast<const void *>(m_window + (offset - m_window_offset)), size};
+    }
+
+    size_t MappedFile::prefetch(size_t offset, size_t size) const noexcept {
+        const auto window_end = m_window_offset + m_window_size;
+        const auto begin = std::max(offset, m_window_offset), end = std::min(offset + size, window_end);
+        if (begin >= end) return std::max(offset, std::min(offset + size, window_end));
+        // advice is given in whole pages, the start is rounded down to the page it lies in
+        const auto first = (begin - m_window_offset) & ~(page_size() - 1);
+        const auto address = m_window + first;
+        const auto length = end - m_window_offset - first;
+#ifdef KLS_SYS_NTOS
+        WIN32_MEMORY_RANGE_ENTRY entry{address, length};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+#else
+        madvise(address, length, MADV_WILLNEED);
+#endif
+        return end;
+    }
+
+    // maps the window that starts at or before offset and covers at least size bytes and as much of the budget as fits
+    void MappedFile::remap(size_t offset, size_t size) {
+        unmap();
+        if (!m_size) return;
+        const auto start = offset & ~(granularity() - 1);
+        const auto length = std::min(std::max(m_budget, size + (offset - start)), m_size - start);
+#ifdef KLS_SYS_NTOS
+        const auto high = DWORD(uint64_t(start) >> 32u), low = DWORD(start & 0xFFFFFFFFu);
+        const auto view = MapViewOfFile(m_mapping, FILE_MAP_READ, high, low, length);
+        if (!view) fail("MapViewOfFile");
+        m_window = static_cast<char *>(view);
+#else
+        const auto view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, m_file, off_t(start));
+        if (view == MAP_FAILED) fail("mmap");
+        if (m_sequential) madvise(view, length, MADV_SEQUENTIAL);
+        m_window = static_cast<char *>(view);
+#endif
+        m_window_offset = start;
+        m_window_size = length;
+    }
+
+    void MappedFile::unmap() noexcept {
+        if (!m_window) return;
+#ifdef KLS_SYS_NTOS
+        UnmapViewOfFile(m_window);
+#else
+        munmap(m_window, m_window_size);
+#endif
+        m_window = nullptr;
+        m_window_offset = m_window_size = 0;
+    }
+
+    void MappedFile::close() noexcept {
+        unmap();
+#ifdef KLS_SYS_NTOS
+        if (m_mapping) CloseHandle(std::exchange(m_mapping, nullptr));
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(std::exchange(m_file, INVALID_HANDLE_VALUE));
+#else
+        if (m_file >= 0) ::close(std::exchange(m_file, -1));
+#endif
+    }
+}
@@ -0,0 +1,162 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <condition_variable>
+#include "kls/Parallel.h"
+
+namespace {
+    struct job {
+        size_t chunks;
+        void (*fn)(void *context, size_t chunk);
+        void *context;
+        std::atomic_size_t next{0};
+        std::exception_ptr error{};
+        std::once_flag failed{};
+        // guarded by the pool lock: the next job in submission order, and the pool threads working on this one
+        job *later{};
+        size_t joined{0}, active{0};
+
+        [[nodiscard]] bool exhausted() const noexcept { return next.load(std::memory_order_relaxed) >= chunks; }
+
+        void work() noexcept {
+            for (size_t chunk; (chunk = next.fetch_add(1, std::memory_order_relaxed)) < chunks;) {
+                try {
+                    fn(context, chunk);
+                }
+                catch (...) {
+                    std::call_once(failed, [this]() noexcept { error = std::current_exception(); });
+                }
+            }
+        }
+    };
+
+    constinit thread_local bool t_pool_thread = false;
+
+    // fork-join pool, the caller works on its own job together with up to mConcurrency - 1 pool threads
+    // jobs of concurrent callers are queued, pool threads join the oldest one that still has chunks and room
+    class pool {
+    public:
+        static pool &get() noexcept {
+            static pool instance{};
+            return instance;
+        }
+
+        ~pool() noexcept {
+            {
+                const std::lock_guard lock(mLock);
+                mStop = true;
+            }
+            mWake.notify_all();
+            for (auto &&thread: mThreads) thread.join();
+        }
+
+        [[nodiscard]] size_t concurrency() const noexcept { return mConcurrency.load(std::memory_order_relaxed); }
+
+        size_t set_concurrency(size_t threads) {
+            threads = std::clamp<size_t>(threads, 1, g_max_concurrency);
+            const std::lock_guard lock(mLock);
+            spawn(threads);
+            mConcurrency.store(threads, std::memory_order_relaxed);
+            return threads;
+        }
+
+        void run(size_t chunks, void (*fn)(void *, size_t), void *context) {
+            if (t_pool_thread) {
+                for (size_t i = 0; i < chunks; ++i) fn(context, i);
+                return;
+            }
+            job work{chunks, fn, context};
+            {
+                const std::lock_guard lock(mLock);
+                spawn(concurrency());
+                *mTail = &work;
+                mTail = &work.later;
+            }
+            mWake.notify_all();
+            work.work();
+            {
+                // pool threads that joined may still be inside their last chunk
+                std::unique_lock lock(mLock);
+                unlink(&work);
+                mDone.wait(lock, [&work]() noexcept { return work.active == 0; });
+            }
+            if (work.error) std::rethrow_exception(work.error);
+        }
+    private:
+        static constexpr size_t g_max_concurrency = 256;
+        std::mutex mLock{};
+        std::condition_variable mWake{}, mDone{};
+        std::vector<std::thread> mThreads{};
+        std::atomic_size_t mConcurrency{std::max<size_t>(1, std::thread::hardware_concurrency())};
+        job *mJobs{}, **mTail{&mJobs};
+        bool mStop{false};
+
+        // threads are started on first use, called with mLock held
+        void spawn(size_t threads) {
+            while (mThreads.size() < threads - 1) mThreads.emplace_back([this]() noexcept { serve(); });
+        }
+
+        // called with mLock held
+        void unlink(job *work) noexcept {
+            auto it = &mJobs;
+            while (*it != work) it = &(*it)->later;
+            if (!(*it = work->later)) mTail = it;
+        }
+
+        // called with mLock held
+        [[nodiscard]] job *pick() const noexcept {
+            for (auto it = mJobs; it; it = it->later) if (!it->exhausted() && it->joined + 1 < concurrency()) return it;
+            return nullptr;
+        }
+
+        void serve() noexcept {
+            t_pool_thread = true;
+            std::unique_lock lock(mLock);
+            for (;;) {
+                job *work = nullptr;
+                mWake.wait(lock, [&]() noexcept { return mStop || (work = pick()); });
+                if (mStop) return;
+                ++work->joined;
+                ++work->active;
+                lock.unlock();
+                work->work();
+                lock.lock();
+                if (--work->active == 0) mDone.notify_all();
+            }
+        }
+    };
+}
+
+namespace kls::parallel {
+    size_t concurrency() noexcept { return pool::get().concurrency(); }
+
+    size_t set_concurrency(size_t threads) { return pool::get().set_concurrency(threads); }
+
+    void detail::run(size_t chunks, void (*fn)(void *, size_t), void *context) {
+        pool::get().run(chunks, fn, context);
+    }
+}
@@ -0,0 +1,61 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "kls/essential/SpanChain.h"
+
+#ifndef KLS_SYS_NTOS
+#include <cerrno>
+
+namespace {
+    constexpr size_t g_iovec_batch = 64;
+
+    template<class Fn>
+    ptrdiff_t transfer(const kls::essential::SpanChain &chain, Fn &&fn) noexcept {
+        iovec vectors[g_iovec_batch];
+        size_t done = 0;
+        // the cursor follows the transfer, so a partial write resumes without rescanning the chain
+        kls::essential::SpanChain::Cursor cursor{};
+        while (done < chain.size()) {
+            const auto count = chain.to_iovec(kls::Span<iovec>(vectors, g_iovec_batch), cursor);
+            const auto result = fn(vectors, int(count));
+            if (result < 0) {
+                if (errno == EINTR) continue;
+                return done ? ptrdiff_t(done) : -1;
+            }
+            if (result == 0) break;
+            done += size_t(result);
+            cursor = chain.advance(cursor, size_t(result));
+        }
+        return ptrdiff_t(done);
+    }
+}
+
+namespace kls::essential {
+    ptrdiff_t writev(int fd, const SpanChain &chain) noexcept {
+        return transfer(chain, [fd](const iovec *vectors, int count) noexcept { return ::writev(fd, vectors, count); });
+    }
+
+    ptrdiff_t readv(int fd, const SpanChain &chain) noexcept {
+        return transfer(chain, [fd](const iovec *vectors, int count) noexcept { return ::readv(fd, vectors, count); });
+    }
+}
+#endif
@@ -0,0 +1,125 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#include "kls/temp/Temp.h"
+#include "kls/essential/Memory.h"
+#include "kls/essential/StreamWriter.h"
+
+namespace {
+    constexpr size_t g_block_size = 4u << 20u; // 4MiB
+    constexpr size_t g_temp_limit = 1u << 18u; // the largest size the temp allocator serves from its own blocks
+}
+
+namespace kls::essential::detail {
+    StreamSegments &StreamSegments::operator=(StreamSegments &&o) noexcept {
+        if (&o != this) {
+            release();
+            m_cursor = std::exchange(o.m_cursor, nullptr);
+            m_limit = std::exchange(o.m_limit, nullptr);
+            m_closed = std::exchange(o.m_closed, 0);
+            m_next = o.m_next;
+            m_segments = std::move(o.m_segments);
+        }
+        return *this;
+    }
+
+    void StreamSegments::write(Span<> data) {
+        auto source = static_cast<const char *>(data.data());
+        auto left = data.size();
+        while (left) {
+            if (m_cursor == m_limit) grow(1);
+            const auto step = std::min(left, remaining());
+            std::memcpy(m_cursor, source, step);
+            m_cursor += step, source += step, left -= step;
+        }
+    }
+
+    SpanChain StreamSegments::written() const {
+        SpanChain chain{};
+        for (size_t i = 0; i + 1 < m_segments.size(); ++i) chain.append(Span<>(m_segments[i].base, m_segments[i].used));
+        if (!m_segments.empty()) chain.append(Span<>(m_segments.back().base, size_t(m_cursor - m_segments.back().base)));
+        return chain;
+    }
+
+    bool StreamSegments::copy_to(Span<> dst) const noexcept {
+        if (dst.size() < offset()) return false;
+        auto cursor = static_cast<char *>(dst.data());
+        for (size_t i = 0; i + 1 < m_segments.size(); ++i) {
+            cursor = std::copy_n(m_segments[i].base, m_segments[i].used, cursor);
+        }
+        if (!m_segments.empty()) std::copy(m_segments.back().base, m_cursor, cursor);
+        return true;
+    }
+
+    Span<> StreamSegments::flatten() {
+        const auto size = offset();
+        if (m_segments.size() > 1) {
+            // the joined copy becomes the only segment, so that later writes append to it
+            auto joined = allocate(size);
+            auto cursor = joined.base;
+            for (size_t i = 0; i + 1 < m_segments.size(); ++i) {
+                cursor = std::copy_n(m_segments[i].base, m_segments[i].used, cursor);
+            }
+            cursor = std::copy(m_segments.back().base, m_cursor, cursor);
+            release();
+            m_segments.clear();
+            m_segments.push_back(joined);
+            m_closed = 0, m_cursor = cursor, m_limit = joined.base + joined.capacity;
+        }
+        return m_segments.empty() ? Span<>(static_cast<void *>(nullptr), size_t(0)) : Span<>(m_segments.back().base, size);
+    }
+
+    void StreamSegments::clear() noexcept {
+        release();
+        m_segments.clear();
+        m_cursor = m_limit = nullptr;
+        m_closed = 0;
+    }
+
+    void StreamSegments::grow(size_t size) {
+        if (m_segments.size() == m_segments.capacity()) m_segments.reserve(std::max(m_segments.size() * 2, size_t(8)));
+        const auto segment = allocate(std::max(size, m_next));
+        if (!m_segments.empty()) {
+            auto &&current = m_segments.back();
+            current.used = size_t(m_cursor - current.base);
+            m_closed += current.used;
+        }
+        m_segments.push_back(segment);
+        m_cursor = segment.base, m_limit = segment.base + segment.capacity;
+        m_next = std::min(segment.capacity * 2, g_block_size);
+    }
+
+    StreamSegments::Segment StreamSegments::allocate(size_t capacity) {
+        if (capacity > g_temp_limit && capacity <= g_block_size) {
+            if (const auto block = rent_4m_block(); block) return Segment{reinterpret_cast<char *>(block), g_block_size, 0, true};
+        }
+        return Segment{static_cast<char *>(temp::allocate(capacity)), capacity, 0, false};
+    }
+
+    void StreamSegments::release() noexcept {
+        for (auto &&segment: m_segments) {
+            if (segment.rented) return_4m_block(reinterpret_cast<uintptr_t>(segment.base));
+            else temp::deallocate(segment.base, segment.capacity);
+        }
+    }
+}
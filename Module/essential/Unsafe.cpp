@@ -0,0 +1,218 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <bit>
+#include <array>
+#include <cstring>
+#include <algorithm>
+#include "kls/Simd.h"
+#include "kls/Macros.h"
+#include "kls/essential/Unsafe.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KLS_UNSAFE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    template<class U>
+    void swap_scalar(char *dst, const char *src, size_t count) noexcept {
+        for (size_t i = 0; i < count; ++i, dst += sizeof(U), src += sizeof(U)) {
+            U value;
+            std::memcpy(&value, src, sizeof(U));
+            kls::essential::byte_swap(value);
+            std::memcpy(dst, &value, sizeof(U));
+        }
+    }
+
+    template<class U>
+    using swap_kernel = void (*)(char *dst, const char *src, size_t count) noexcept;
+
+#if KLS_UNSAFE_X86
+    // byte reversal of every value within a 16 byte lane
+    template<size_t Size>
+    alignas(64) constexpr auto g_reverse = []() {
+        std::array<char, 64> mask{};
+        for (size_t i = 0; i < mask.size(); ++i) mask[i] = char(i % 16 / Size * Size + Size - 1 - i % Size);
+        return mask;
+    }();
+
+    template<class U>
+    [[gnu::target("ssse3")]] void swap_ssse3(char *dst, const char *src, size_t count) noexcept {
+        const auto mask = _mm_load_si128(reinterpret_cast<const __m128i *>(g_reverse<sizeof(U)>.data()));
+        size_t i = 0;
+        for (const auto bytes = count * sizeof(U); i + 16 <= bytes; i += 16) {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_shuffle_epi8(v, mask));
+        }
+        swap_scalar<U>(dst + i, src + i, count - i / sizeof(U));
+    }
+
+    template<class U>
+    [[gnu::target("avx2")]] void swap_avx2(char *dst, const char *src, size_t count) noexcept {
+        const auto mask = _mm256_load_si256(reinterpret_cast<const __m256i *>(g_reverse<sizeof(U)>.data()));
+        size_t i = 0;
+        for (const auto bytes = count * sizeof(U); i + 32 <= bytes; i += 32) {
+            const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_shuffle_epi8(v, mask));
+        }
+        swap_ssse3<U>(dst + i, src + i, count - i / sizeof(U));
+    }
+
+    template<class U>
+    [[gnu::target("avx512f,avx512bw")]] void swap_avx512(char *dst, const char *src, size_t count) noexcept {
+        const auto mask = _mm512_load_si512(g_reverse<sizeof(U)>.data());
+        size_t i = 0;
+        for (const auto bytes = count * sizeof(U); i + 64 <= bytes; i += 64) {
+            const auto v = _mm512_loadu_si512(src + i);
+            _mm512_storeu_si512(dst + i, _mm512_shuffle_epi8(v, mask));
+        }
+        swap_avx2<U>(dst + i, src + i, count - i / sizeof(U));
+    }
+
+    const bool g_ssse3 = []() noexcept {
+        __builtin_cpu_init();
+        return bool(__builtin_cpu_supports("ssse3"));
+    }();
+#endif
+
+    template<class U>
+    swap_kernel<U> pick() noexcept {
+        switch (kls::simd::level()) {
+#if KLS_UNSAFE_X86
+            case kls::simd::Level::AVX512:
+                return &swap_avx512<U>;
+            case kls::simd::Level::AVX2:
+                return &swap_avx2<U>;
+            case kls::simd::Level::SSE2:
+                return g_ssse3 ? &swap_ssse3<U> : &swap_scalar<U>;
+#endif
+            default:
+                return &swap_scalar<U>;
+        }
+    }
+}
+
+namespace {
+    // one LEB128 value of at most 32 bits, returns the bytes used or 0 if the value is truncated or too large
+    KLS_FORCE_INLINE inline size_t decode_varint(const uint8_t *p, size_t left, uint32_t &out) noexcept {
+        uint32_t result = 0;
+        for (size_t i = 0; i < 5 && i < left; ++i) {
+            const auto byte = p[i];
+            if (i == 4 && byte > 0x0F) return 0;
+            result |= uint32_t(byte & 0x7F) << (7 * i);
+            if (!(byte & 0x80)) {
+                out = result;
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    size_t decode_varints_scalar(const uint8_t *src, size_t bytes, uint32_t *dst, size_t count) noexcept {
+        size_t used = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const auto n = decode_varint(src + used, bytes - used, dst[i]);
+            if (!n) return SIZE_MAX;
+            used += n;
+        }
+        return used;
+    }
+
+#if KLS_UNSAFE_X86 && defined(__SSE2__)
+    // Looks at the continuation bits of 16 bytes at a time. Blocks of sixteen 1 byte or eight 2 byte values, the
+    // common shapes of small integers, are decoded with a few shifts and unpacks. In other blocks the bits give the
+    // length of every value that ends inside the block, each is then gathered from one 64 bit load. What is left
+    // near the end of the input is decoded byte by byte
+    size_t decode_varints_sse2(const uint8_t *src, size_t bytes, uint32_t *dst, size_t count) noexcept {
+        const auto zero = _mm_setzero_si128();
+        size_t used = 0, i = 0;
+        while (i < count && bytes - used >= 16) {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + used));
+            const auto mask = unsigned(_mm_movemask_epi8(v));
+            if (mask == 0 && count - i >= 16) {
+                const auto lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_unpacklo_epi16(lo, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 4), _mm_unpackhi_epi16(lo, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 8), _mm_unpacklo_epi16(hi, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 12), _mm_unpackhi_epi16(hi, zero));
+                i += 16;
+                used += 16;
+                continue;
+            }
+            if (mask == 0x5555 && count - i >= 8) {
+                const auto low = _mm_and_si128(v, _mm_set1_epi16(0x7F));
+                const auto value = _mm_or_si128(low, _mm_slli_epi16(_mm_srli_epi16(v, 8), 7));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_unpacklo_epi16(value, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i + 4), _mm_unpackhi_epi16(value, zero));
+                i += 8;
+                used += 16;
+                continue;
+            }
+            // every value that ends inside the block, as long as 8 bytes can be loaded from its start
+            size_t pos = 0;
+            while (i < count && bytes - used - pos >= sizeof(uint64_t)) {
+                const auto len = size_t(std::countr_one(mask >> pos)) + 1;
+                if (len > 5) return SIZE_MAX;
+                if (pos + len > 16) break;
+                uint64_t word;
+                std::memcpy(&word, src + used + pos, sizeof(word));
+                if constexpr (std::endian::native == std::endian::big) kls::essential::byte_swap(word);
+                word &= (uint64_t(1) << (8 * len)) - 1;
+                if (word >> 36) return SIZE_MAX; // a 5th byte with more than 4 bits
+                dst[i++] = uint32_t((word & 0x7F) | ((word >> 1) & 0x3F80) | ((word >> 2) & 0x1FC000) |
+                                    ((word >> 3) & 0xFE00000) | ((word >> 4) & 0xF0000000));
+                pos += len;
+            }
+            if (!pos) break;
+            used += pos;
+        }
+        const auto rest = decode_varints_scalar(src + used, bytes - used, dst + i, count - i);
+        return rest == SIZE_MAX ? SIZE_MAX : used + rest;
+    }
+#endif
+}
+
+namespace kls::essential::detail {
+    void byte_swap(void *dst, const void *src, size_t count, size_t size) noexcept {
+        const auto d = static_cast<char *>(dst);
+        const auto s = static_cast<const char *>(src);
+        switch (size) {
+            case 2:
+                return pick<uint16_t>()(d, s, count);
+            case 4:
+                return pick<uint32_t>()(d, s, count);
+            case 8:
+                return pick<uint64_t>()(d, s, count);
+            default:
+                return;
+        }
+    }
+
+    size_t decode_varints(const void *src, size_t bytes, uint32_t *dst, size_t count) noexcept {
+        const auto p = static_cast<const uint8_t *>(src);
+#if KLS_UNSAFE_X86 && defined(__SSE2__)
+        if (simd::level() != simd::Level::Scalar) return decode_varints_sse2(p, bytes, dst, count);
+#endif
+        return decode_varints_scalar(p, bytes, dst, count);
+    }
+}
@@ -0,0 +1,380 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <bit>
+#include <array>
+#include <cstring>
+#include "kls/Hash.h"
+#include "kls/Simd.h"
+#include "kls/Macros.h"
+#include "kls/essential/Unsafe.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define KLS_HASH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    using kls::hash::Hasher64;
+
+    KLS_FORCE_INLINE inline uint32_t read32(const unsigned char *p) noexcept {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        if constexpr (std::endian::native == std::endian::big) kls::essential::byte_swap(v);
+        return v;
+    }
+
+    KLS_FORCE_INLINE inline uint64_t read64(const unsigned char *p) noexcept {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        if constexpr (std::endian::native == std::endian::big) kls::essential::byte_swap(v);
+        return v;
+    }
+
+    // CRC-32C, reflected Castagnoli polynomial. The kernels work on the raw register, without the final inversion
+    constexpr uint32_t g_poly = 0x82F63B78;
+
+    // slicing by 8, table[k][n] is the register for byte n followed by k zero bytes
+    constexpr auto g_crc_table = []() {
+        std::array<std::array<uint32_t, 256>, 8> table{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? (c >> 1) ^ g_poly : c >> 1;
+            table[0][n] = c;
+        }
+        for (uint32_t n = 0; n < 256; ++n) {
+            for (int k = 1; k < 8; ++k) table[k][n] = (table[k - 1][n] >> 8) ^ table[0][table[k - 1][n] & 0xFF];
+        }
+        return table;
+    }();
+
+    uint32_t crc_software(uint32_t crc, const unsigned char *p, size_t n) noexcept {
+        const auto &t = g_crc_table;
+        for (; n && (reinterpret_cast<uintptr_t>(p) & 7); --n) crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+        for (; n >= 8; n -= 8, p += 8) {
+            const auto lo = read32(p) ^ crc, hi = read32(p + 4);
+            crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+                  t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        }
+        for (; n; --n) crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+        return crc;
+    }
+
+    using gf2_matrix = std::array<uint32_t, 32>;
+
+    constexpr uint32_t gf2_times(const gf2_matrix &matrix, uint32_t vector) noexcept {
+        uint32_t result = 0;
+        for (size_t i = 0; vector; vector >>= 1, ++i) if (vector & 1) result ^= matrix[i];
+        return result;
+    }
+
+    // the operator appending len zero bytes to a register, split into byte tables. len must be a power of two
+    constexpr auto zeros_table(size_t len) noexcept {
+        gf2_matrix op{g_poly};
+        for (uint32_t n = 1; n < 32; ++n) op[n] = uint32_t(1) << (n - 1);
+        for (size_t bits = 1; bits < len * 8; bits <<= 1) {
+            gf2_matrix squared{};
+            for (size_t n = 0; n < 32; ++n) squared[n] = gf2_times(op, op[n]);
+            op = squared;
+        }
+        std::array<std::array<uint32_t, 256>, 4> table{};
+        for (uint32_t n = 0; n < 256; ++n) {
+            for (int k = 0; k < 4; ++k) table[k][n] = gf2_times(op, n << (8 * k));
+        }
+        return table;
+    }
+
+    constexpr size_t g_crc_long = 8192, g_crc_short = 256;
+    constexpr auto g_crc_long_zeros = zeros_table(g_crc_long);
+    constexpr auto g_crc_short_zeros = zeros_table(g_crc_short);
+
+    KLS_FORCE_INLINE inline uint64_t shift(const std::array<std::array<uint32_t, 256>, 4> &zeros, uint64_t crc) noexcept {
+        return zeros[0][crc & 0xFF] ^ zeros[1][(crc >> 8) & 0xFF] ^ zeros[2][(crc >> 16) & 0xFF] ^ zeros[3][crc >> 24];
+    }
+
+#if KLS_HASH_X86
+    // three independent streams keep the crc32 unit busy, the streams are merged by appending zeros to the earlier ones
+    template<size_t Len>
+    [[gnu::target("sse4.2")]] KLS_FORCE_INLINE inline uint64_t crc_streams(
+            uint64_t crc, const unsigned char *&p, size_t &n,
+            const std::array<std::array<uint32_t, 256>, 4> &zeros
+    ) noexcept {
+        for (; n >= 3 * Len; n -= 3 * Len) {
+            uint64_t c0 = crc, c1 = 0, c2 = 0;
+            for (const auto end = p + Len; p < end; p += 8) {
+                c0 = _mm_crc32_u64(c0, read64(p));
+                c1 = _mm_crc32_u64(c1, read64(p + Len));
+                c2 = _mm_crc32_u64(c2, read64(p + 2 * Len));
+            }
+            crc = shift(zeros, shift(zeros, c0) ^ c1) ^ c2;
+            p += 2 * Len;
+        }
+        return crc;
+    }
+
+    [[gnu::target("sse4.2")]] uint32_t crc_hardware(uint32_t crc, const unsigned char *p, size_t n) noexcept {
+        uint64_t c = crc;
+        for (; n && (reinterpret_cast<uintptr_t>(p) & 7); --n) c = _mm_crc32_u8(uint32_t(c), *p++);
+        c = crc_streams<g_crc_long>(c, p, n, g_crc_long_zeros);
+        c = crc_streams<g_crc_short>(c, p, n, g_crc_short_zeros);
+        for (; n >= 8; n -= 8, p += 8) c = _mm_crc32_u64(c, read64(p));
+        for (; n; --n) c = _mm_crc32_u8(uint32_t(c), *p++);
+        return uint32_t(c);
+    }
+
+    // detected on first use, crc32c may run during the static initialization of other translation units
+    bool crc_instruction() noexcept {
+        static const bool supported = []() noexcept {
+            __builtin_cpu_init();
+            return bool(__builtin_cpu_supports("sse4.2"));
+        }();
+        return supported;
+    }
+#else
+    bool crc_instruction() noexcept { return false; }
+#endif
+
+    constexpr uint64_t g_prime1 = 0x9E3779B185EBCA87, g_prime2 = 0xC2B2AE3D27D4EB4F, g_prime3 = 0x165667B19E3779F9;
+    constexpr uint64_t g_prime4 = 0x85EBCA77C2B2AE63, g_prime5 = 0x27D4EB2F165667C5;
+    constexpr uint64_t g_prime32_1 = 0x9E3779B1, g_prime32_2 = 0x85EBCA77, g_prime32_3 = 0xC2B2AE3D;
+
+    // key material for the hash, 192 bytes from splitmix64
+    constexpr auto g_secret = []() {
+        std::array<unsigned char, 192> secret{};
+        uint64_t state = 0x6B6C732D68617368;
+        for (size_t i = 0; i < secret.size(); i += 8) {
+            uint64_t z = (state += 0x9E3779B97F4A7C15);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+            z ^= z >> 31;
+            for (size_t j = 0; j < 8; ++j) secret[i + j] = static_cast<unsigned char>(z >> (8 * j));
+        }
+        return secret;
+    }();
+
+    constexpr size_t g_stripe = Hasher64::stripe, g_block_stripes = 16;
+    constexpr size_t g_scramble_key = 128, g_last_key = 121, g_merge_key = 11;
+
+    // 64x64 to 128 bit multiply with the halves folded together
+    KLS_FORCE_INLINE inline uint64_t mum(uint64_t a, uint64_t b) noexcept {
+#ifdef __SIZEOF_INT128__
+        const auto r = static_cast<unsigned __int128>(a) * b;
+        return uint64_t(r) ^ uint64_t(r >> 64);
+#else
+        const uint64_t ll = (a & 0xFFFFFFFF) * (b & 0xFFFFFFFF), hl = (a >> 32) * (b & 0xFFFFFFFF);
+        const uint64_t lh = (a & 0xFFFFFFFF) * (b >> 32), hh = (a >> 32) * (b >> 32);
+        const uint64_t cross = (ll >> 32) + (hl & 0xFFFFFFFF) + lh;
+        return ((cross << 32) | (ll & 0xFFFFFFFF)) ^ ((hl >> 32) + (cross >> 32) + hh);
+#endif
+    }
+
+    KLS_FORCE_INLINE inline uint64_t avalanche(uint64_t h) noexcept {
+        h ^= h >> 37;
+        h *= 0x165667919E3779F9;
+        return h ^ (h >> 32);
+    }
+
+    uint64_t hash_short(const unsigned char *p, size_t len, uint64_t seed) noexcept {
+        const auto s = g_secret.data();
+        if (len > 16) {
+            const auto mix = [seed](const unsigned char *q, const unsigned char *k) noexcept {
+                return mum(read64(q) ^ (read64(k) + seed), read64(q + 8) ^ (read64(k + 8) - seed));
+            };
+            uint64_t acc = len * g_prime1;
+            if (len > 32) {
+                if (len > 64) {
+                    if (len > 96) acc += mix(p + 48, s + 96) + mix(p + len - 64, s + 112);
+                    acc += mix(p + 32, s + 64) + mix(p + len - 48, s + 80);
+                }
+                acc += mix(p + 16, s + 32) + mix(p + len - 32, s + 48);
+            }
+            return avalanche(acc + mix(p, s) + mix(p + len - 16, s + 16));
+        }
+        if (len > 8) {
+            const auto lo = read64(p) ^ (read64(s + 24) + seed), hi = read64(p + len - 8) ^ (read64(s + 32) - seed);
+            return avalanche(len + std::rotl(lo, 32) + hi + mum(lo, hi));
+        }
+        if (len >= 4) {
+            const auto v = (uint64_t(read32(p)) << 32 | read32(p + len - 4)) ^ (read64(s + 8) - seed);
+            return avalanche(mum(v, g_prime2 ^ len) + len);
+        }
+        if (len) {
+            const uint32_t v = uint32_t(p[0]) << 16 | uint32_t(p[len >> 1]) << 24 | p[len - 1] | uint32_t(len) << 8;
+            return avalanche(mum(v ^ (read64(s) + seed), g_prime1));
+        }
+        return avalanche(seed ^ read64(s + 56) ^ read64(s + 64));
+    }
+
+    KLS_FORCE_INLINE inline void accumulate(uint64_t *acc, const unsigned char *p, const unsigned char *k) noexcept {
+        uint64_t d[8], product[8];
+        for (size_t j = 0; j < 8; ++j) {
+            d[j] = read64(p + 8 * j);
+            const auto dk = d[j] ^ read64(k + 8 * j);
+            product[j] = (dk & 0xFFFFFFFF) * (dk >> 32);
+        }
+        for (size_t j = 0; j < 8; ++j) acc[j] += product[j] + d[j ^ 1];
+    }
+
+    KLS_FORCE_INLINE inline void scramble(uint64_t *acc, const unsigned char *k) noexcept {
+        for (size_t j = 0; j < 8; ++j) {
+            auto a = acc[j];
+            a ^= a >> 47;
+            a ^= read64(k + 8 * j);
+            acc[j] = a * g_prime32_1;
+        }
+    }
+
+    // accumulates n stripes, count is the position within the current block of stripes, the new position is returned
+    KLS_FORCE_INLINE inline size_t run_stripes(uint64_t *out, const unsigned char *p, size_t n, size_t count) noexcept {
+        uint64_t acc[8];
+        std::memcpy(acc, out, sizeof(acc));
+        for (size_t i = 0; i < n; ++i, p += g_stripe) {
+            accumulate(acc, p, g_secret.data() + 8 * count);
+            if (++count == g_block_stripes) {
+                scramble(acc, g_secret.data() + g_scramble_key);
+                count = 0;
+            }
+        }
+        std::memcpy(out, acc, sizeof(acc));
+        return count;
+    }
+
+#define KLS_HASH_TARGET(NAME, TARGET)                                                                              \
+    TARGET size_t NAME(uint64_t *acc, const unsigned char *p, size_t n, size_t count) noexcept {                   \
+        return run_stripes(acc, p, n, count);                                                                      \
+    }
+
+    KLS_HASH_TARGET(stripes_portable, )
+#if KLS_HASH_X86
+    KLS_HASH_TARGET(stripes_avx2, [[gnu::target("avx2")]])
+    KLS_HASH_TARGET(stripes_avx512, [[gnu::target("avx512f,avx512bw,avx512vl,avx512dq")]])
+#endif
+
+#undef KLS_HASH_TARGET
+
+    size_t stripes(uint64_t *acc, const unsigned char *p, size_t n, size_t count) noexcept {
+        switch (kls::simd::level()) {
+#if KLS_HASH_X86
+            case kls::simd::Level::AVX512:
+                return stripes_avx512(acc, p, n, count);
+            case kls::simd::Level::AVX2:
+                return stripes_avx2(acc, p, n, count);
+#endif
+            default:
+                return stripes_portable(acc, p, n, count);
+        }
+    }
+
+    void init(uint64_t *acc, uint64_t seed) noexcept {
+        const uint64_t start[8]{g_prime32_3, g_prime1, g_prime2, g_prime3, g_prime4, g_prime32_2, g_prime5, g_prime32_1};
+        for (size_t j = 0; j < 8; ++j) acc[j] = start[j] + ((j & 1) ? 0 - seed : seed);
+    }
+
+    uint64_t merge(const uint64_t *acc, uint64_t len) noexcept {
+        const auto s = g_secret.data() + g_merge_key;
+        uint64_t result = len * g_prime1;
+        for (size_t i = 0; i < 4; ++i) {
+            result += mum(acc[2 * i] ^ read64(s + 16 * i), acc[2 * i + 1] ^ read64(s + 16 * i + 8));
+        }
+        return avalanche(result);
+    }
+
+    // inputs up to this size take the short path, longer ones are striped with the last stripe ending at the end
+    constexpr size_t g_short_limit = 128;
+}
+
+namespace kls::hash {
+    uint32_t crc32c(Span<> data, uint32_t crc) noexcept {
+        const auto p = static_cast<const unsigned char *>(data.data());
+#if KLS_HASH_X86
+        if (crc32c_accelerated()) return ~crc_hardware(~crc, p, data.size());
+#endif
+        return ~crc_software(~crc, p, data.size());
+    }
+
+    bool crc32c_accelerated() noexcept { return crc_instruction() && simd::level() != simd::Level::Scalar; }
+
+    uint64_t hash64(Span<> data, uint64_t seed) noexcept {
+        const auto p = static_cast<const unsigned char *>(data.data());
+        const auto len = data.size();
+        if (len <= g_short_limit) return hash_short(p, len, seed);
+        uint64_t acc[8];
+        init(acc, seed);
+        stripes(acc, p, (len - 1) / g_stripe, 0);
+        accumulate(acc, p + len - g_stripe, g_secret.data() + g_last_key);
+        return merge(acc, len);
+    }
+
+    void Hasher64::reset(uint64_t seed) noexcept {
+        init(mAcc, seed);
+        mSeed = seed;
+        mTotal = 0;
+        mStripes = 0;
+        mBuffered = 0;
+    }
+
+    // full buffers are only striped once more input follows, so the digest always finds the final stripe buffered
+    void Hasher64::update(Span<> data) noexcept {
+        auto p = static_cast<const unsigned char *>(data.data());
+        auto n = data.size();
+        mTotal += n;
+        if (mBuffered + n <= buffer) {
+            if (n) std::memcpy(mBuffer + mBuffered, p, n);
+            mBuffered += n;
+            return;
+        }
+        if (mBuffered) {
+            const auto fill = buffer - mBuffered;
+            std::memcpy(mBuffer + mBuffered, p, fill);
+            p += fill;
+            n -= fill;
+            mStripes = stripes(mAcc, mBuffer, buffer / stripe, mStripes);
+            std::memcpy(mLast, mBuffer + buffer - stripe, stripe);
+            mBuffered = 0;
+        }
+        if (n > buffer) {
+            const auto whole = (n - 1) / buffer * buffer;
+            mStripes = stripes(mAcc, p, whole / stripe, mStripes);
+            p += whole;
+            n -= whole;
+            std::memcpy(mLast, p - stripe, stripe);
+        }
+        std::memcpy(mBuffer, p, n);
+        mBuffered = n;
+    }
+
+    uint64_t Hasher64::digest() const noexcept {
+        if (mTotal <= g_short_limit) return hash_short(mBuffer, mTotal, mSeed);
+        uint64_t acc[8];
+        std::memcpy(acc, mAcc, sizeof(acc));
+        stripes(acc, mBuffer, (mBuffered - 1) / stripe, mStripes);
+        unsigned char last[stripe];
+        const unsigned char *tail = mBuffer + mBuffered - stripe;
+        if (mBuffered < stripe) {
+            std::memcpy(last, mLast + mBuffered, stripe - mBuffered);
+            std::memcpy(last + stripe - mBuffered, mBuffer, mBuffered);
+            tail = last;
+        }
+        accumulate(acc, tail, g_secret.data() + g_last_key);
+        return merge(acc, mTotal);
+    }
+}
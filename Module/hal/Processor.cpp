@@ -0,0 +1,73 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include "kls/hal/System.h"
+#include "kls/hal/Processor.h"
+
+#if !defined(KLS_SYS_NTOS) && defined(__linux__) && __has_include(<sched.h>)
+#include <sched.h>
+#define KLS_PROCESSOR_SCHED_GETCPU 1
+#if __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>
+#ifdef RSEQ_SIG
+#define KLS_PROCESSOR_RSEQ 1
+#endif
+#endif
+#endif
+
+namespace {
+#if KLS_PROCESSOR_RSEQ
+    // glibc registers an rseq area for every thread, the kernel keeps its cpu_id up to date on every migration
+    const volatile rseq *rseq_area() noexcept {
+        if (__rseq_size == 0) return nullptr;
+        return reinterpret_cast<const rseq *>(static_cast<const char *>(__builtin_thread_pointer()) + __rseq_offset);
+    }
+#endif
+}
+
+namespace kls::hal::processor {
+    uint32_t current() noexcept {
+#ifdef KLS_SYS_NTOS
+        return GetCurrentProcessorNumber();
+#elif KLS_PROCESSOR_SCHED_GETCPU
+#if KLS_PROCESSOR_RSEQ
+        if (const auto area = rseq_area(); area) {
+            if (const auto cpu = int32_t(area->cpu_id); cpu >= 0) return uint32_t(cpu);
+        }
+#endif
+        if (const auto cpu = sched_getcpu(); cpu >= 0) return uint32_t(cpu);
+        return 0;
+#else
+        // no way to query, spread the threads instead
+        static thread_local const auto hash = uint32_t(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        return hash % count();
+#endif
+    }
+
+    uint32_t count() noexcept {
+        static const uint32_t count = std::max(std::thread::hardware_concurrency(), 1u);
+        return count;
+    }
+}
@@ -0,0 +1,245 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <atomic>
+#include <numeric>
+#include <algorithm>
+#include "kls/Simd.h"
+#include "kls/Macros.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KLS_SIMD_X86 1
+#endif
+
+namespace {
+    using namespace kls::simd;
+    using kls::simd::detail::sum_t;
+    using kls::simd::detail::Kernels;
+
+    // reference loops, also used as the fallback on builds without dispatch
+    template<class T>
+    struct scalar {
+        static void fill(T *data, size_t size, T value) noexcept { std::fill_n(data, size, value); }
+
+        static bool equal(const T *a, const T *b, size_t size) noexcept { return std::equal(a, a + size, b); }
+
+        static size_t find(const T *data, size_t size, T value) noexcept {
+            return std::find(data, data + size, value) - data;
+        }
+
+        static size_t find_not(const T *data, size_t size, T value) noexcept {
+            return std::find_if(data, data + size, [value](T x) { return x != value; }) - data;
+        }
+
+        static size_t count(const T *data, size_t size, T value) noexcept {
+            return std::count(data, data + size, value);
+        }
+
+        static T min(const T *data, size_t size) noexcept { return *std::min_element(data, data + size); }
+
+        static T max(const T *data, size_t size) noexcept { return *std::max_element(data, data + size); }
+
+        static sum_t<T> sum(const T *data, size_t size) noexcept {
+            return std::accumulate(data, data + size, sum_t<T>{});
+        }
+
+        static constexpr Kernels<T> table{&fill, &equal, &find, &find_not, &count, &min, &max, &sum};
+    };
+
+    // The loops work on blocks with a fixed trip count, which the compiler turns into whole vectors of the target
+    // the calling wrapper is built for. Only the tail of the span is processed element by element
+    template<class T>
+    struct blocked {
+        // elements per block for the comparing kernels, four 512 bit vectors
+        static constexpr size_t width = 256 / sizeof(T);
+        // independent accumulators for the reducing kernels, two 512 bit vectors
+        static constexpr size_t lanes = 128 / sizeof(T);
+        static constexpr size_t sum_lanes = 128 / sizeof(sum_t<T>);
+
+        KLS_FORCE_INLINE static void fill(T *data, size_t size, T value) noexcept {
+            size_t i = 0;
+            for (; i + width <= size; i += width) for (size_t j = 0; j < width; ++j) data[i + j] = value;
+            for (; i < size; ++i) data[i] = value;
+        }
+
+        KLS_FORCE_INLINE static bool equal(const T *a, const T *b, size_t size) noexcept {
+            size_t i = 0;
+            for (; i + width <= size; i += width) {
+                unsigned diff = 0;
+                for (size_t j = 0; j < width; ++j) diff |= a[i + j] != b[i + j];
+                if (diff) return false;
+            }
+            for (; i < size; ++i) if (a[i] != b[i]) return false;
+            return true;
+        }
+
+        template<bool Match>
+        KLS_FORCE_INLINE static size_t search(const T *data, size_t size, T value) noexcept {
+            size_t i = 0;
+            for (; i + width <= size; i += width) {
+                unsigned hit = 0;
+                for (size_t j = 0; j < width; ++j) hit |= (data[i + j] == value) == Match;
+                if (hit) break;
+            }
+            for (; i < size; ++i) if ((data[i] == value) == Match) return i;
+            return size;
+        }
+
+        KLS_FORCE_INLINE static size_t count(const T *data, size_t size, T value) noexcept {
+            size_t i = 0, result = 0;
+            for (; i + width <= size; i += width) {
+                uint32_t hits = 0;
+                for (size_t j = 0; j < width; ++j) hits += data[i + j] == value;
+                result += hits;
+            }
+            for (; i < size; ++i) result += data[i] == value;
+            return result;
+        }
+
+        template<class Pick>
+        KLS_FORCE_INLINE static T reduce(const T *data, size_t size, Pick pick) noexcept {
+            T acc[lanes];
+            for (size_t j = 0; j < lanes; ++j) acc[j] = data[0];
+            size_t i = 0;
+            for (; i + lanes <= size; i += lanes) for (size_t j = 0; j < lanes; ++j) acc[j] = pick(data[i + j], acc[j]);
+            for (; i < size; ++i) acc[0] = pick(data[i], acc[0]);
+            for (size_t j = 1; j < lanes; ++j) acc[0] = pick(acc[j], acc[0]);
+            return acc[0];
+        }
+
+        KLS_FORCE_INLINE static T min(const T *data, size_t size) noexcept {
+            return reduce(data, size, [](T x, T acc) { return x < acc ? x : acc; });
+        }
+
+        KLS_FORCE_INLINE static T max(const T *data, size_t size) noexcept {
+            return reduce(data, size, [](T x, T acc) { return acc < x ? x : acc; });
+        }
+
+        KLS_FORCE_INLINE static sum_t<T> sum(const T *data, size_t size) noexcept {
+            sum_t<T> acc[sum_lanes]{};
+            size_t i = 0;
+            for (; i + sum_lanes <= size; i += sum_lanes) {
+                for (size_t j = 0; j < sum_lanes; ++j) acc[j] += data[i + j];
+            }
+            for (; i < size; ++i) acc[0] += data[i];
+            for (size_t j = 1; j < sum_lanes; ++j) acc[0] += acc[j];
+            return acc[0];
+        }
+    };
+
+    // instantiates the blocked kernels for one target
+#define KLS_SIMD_TARGET(NAME, TARGET)                                                                              \
+    template<class T>                                                                                              \
+    struct NAME {                                                                                                  \
+        using B = blocked<T>;                                                                                      \
+        TARGET static void fill(T *d, size_t n, T v) noexcept { B::fill(d, n, v); }                                \
+        TARGET static bool equal(const T *a, const T *b, size_t n) noexcept { return B::equal(a, b, n); }          \
+        TARGET static size_t find(const T *d, size_t n, T v) noexcept { return B::template search<true>(d, n, v); }\
+        TARGET static size_t find_not(const T *d, size_t n, T v) noexcept {                                        \
+            return B::template search<false>(d, n, v);                                                             \
+        }                                                                                                          \
+        TARGET static size_t count(const T *d, size_t n, T v) noexcept { return B::count(d, n, v); }               \
+        TARGET static T min(const T *d, size_t n) noexcept { return B::min(d, n); }                                \
+        TARGET static T max(const T *d, size_t n) noexcept { return B::max(d, n); }                                \
+        TARGET static sum_t<T> sum(const T *d, size_t n) noexcept { return B::sum(d, n); }                         \
+        static constexpr Kernels<T> table{&fill, &equal, &find, &find_not, &count, &min, &max, &sum};              \
+    };
+
+#if KLS_SIMD_X86
+    KLS_SIMD_TARGET(sse2, )
+    KLS_SIMD_TARGET(avx2, [[gnu::target("avx2")]])
+    KLS_SIMD_TARGET(avx512, [[gnu::target("avx512f,avx512bw,avx512vl,avx512dq")]])
+#endif
+
+#undef KLS_SIMD_TARGET
+
+    Level detect() noexcept {
+#if KLS_SIMD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq"))
+            return Level::AVX512;
+        if (__builtin_cpu_supports("avx2")) return Level::AVX2;
+        return Level::SSE2;
+#else
+        return Level::Scalar;
+#endif
+    }
+
+    // detected on first use, as kernels may run during the static initialization of other translation units
+    constexpr int g_undetected = -1;
+    constinit std::atomic<int> g_level{g_undetected};
+
+    Level current() noexcept {
+        auto level = g_level.load(std::memory_order_relaxed);
+        if (level == g_undetected) [[unlikely]] {
+            // a concurrent set_level() wins against the detected default
+            if (g_level.compare_exchange_strong(level, int(supported_level()), std::memory_order_relaxed))
+                return supported_level();
+        }
+        return Level(level);
+    }
+}
+
+namespace kls::simd {
+    Level supported_level() noexcept {
+        static const Level supported = detect();
+        return supported;
+    }
+
+    Level level() noexcept { return current(); }
+
+    Level set_level(Level level) noexcept {
+        const auto selected = std::min(level, supported_level());
+        g_level.store(int(selected), std::memory_order_relaxed);
+        return selected;
+    }
+
+    namespace detail {
+        template<class T>
+        const Kernels<T> &kernels() noexcept {
+            switch (current()) {
+#if KLS_SIMD_X86
+                case Level::AVX512:
+                    return avx512<T>::table;
+                case Level::AVX2:
+                    return avx2<T>::table;
+                case Level::SSE2:
+                    return sse2<T>::table;
+#endif
+                default:
+                    return scalar<T>::table;
+            }
+        }
+
+        template const Kernels<int8_t> &kernels() noexcept;
+        template const Kernels<uint8_t> &kernels() noexcept;
+        template const Kernels<int16_t> &kernels() noexcept;
+        template const Kernels<uint16_t> &kernels() noexcept;
+        template const Kernels<int32_t> &kernels() noexcept;
+        template const Kernels<uint32_t> &kernels() noexcept;
+        template const Kernels<int64_t> &kernels() noexcept;
+        template const Kernels<uint64_t> &kernels() noexcept;
+        template const Kernels<float> &kernels() noexcept;
+        template const Kernels<double> &kernels() noexcept;
+    }
+}
@@ -0,0 +1,212 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <new>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "kls/pmr/Pool.h"
+#include "kls/hal/Processor.h"
+
+namespace {
+    using namespace kls::pmr::detail::pool;
+
+    struct batch {
+        Node *next;
+        batch *next_batch;
+    };
+
+    struct alignas(64) processor_cache {
+        std::atomic_flag lock{};
+        struct {
+            Node *head;
+            uint32_t count;
+        } bins[class_count]{};
+    };
+
+    class processor_caches {
+    public:
+        processor_caches() : m_count(kls::hal::processor::count()),
+                             m_caches(std::make_unique<processor_cache[]>(m_count)) {}
+
+        // the lock is almost never contended, unless the owner got preempted or migrated while holding it
+        // in which case the neighbouring caches are tried before giving up the time slice
+        processor_cache &acquire() noexcept {
+            const auto first = kls::hal::processor::current();
+            for (;;) {
+                for (uint32_t i = 0; i < m_count; ++i) {
+                    auto &cache = m_caches[(first + i) % m_count];
+                    if (!cache.lock.test_and_set(std::memory_order_acquire)) return cache;
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        static void release(processor_cache &cache) noexcept { cache.lock.clear(std::memory_order_release); }
+
+        // the depot is never called with a cache lock held, a refill is fetched after releasing the lock
+        void *allocate(const size_t index) noexcept {
+            auto &cache = acquire();
+            const auto node = pop(cache, index);
+            release(cache);
+            if (node) return node;
+            uint32_t count{};
+            const auto list = depot_take(index, count);
+            if (list) stash(index, list->next, count - 1);
+            return list;
+        }
+
+        void deallocate(void *const p, const size_t index) noexcept {
+            auto &cache = acquire();
+            const auto overflow = push(cache, index, static_cast<Node *>(p));
+            release(cache);
+            if (overflow) depot_give_batch(index, overflow);
+        }
+
+        bool allocate_batch(kls::Span<void *> out, const size_t index) noexcept {
+            size_t i = 0;
+            auto &cache = acquire();
+            for (; i < out.size(); ++i) if (out.data()[i] = pop(cache, index); !out.data()[i]) break;
+            release(cache);
+            while (i < out.size()) {
+                uint32_t count{};
+                auto list = depot_take(index, count);
+                if (!list) return deallocate_batch(out.keep_front(i), index), false;
+                for (; list && i < out.size(); ++i, --count) out.data()[i] = std::exchange(list, list->next);
+                if (list) stash(index, list, count);
+            }
+            return true;
+        }
+
+        // overflow batches are chained through the second word of their head and handed over after the release
+        void deallocate_batch(kls::Span<void *> ptrs, const size_t index) noexcept {
+            batch *batches = nullptr;
+            auto &cache = acquire();
+            for (const auto p: ptrs) {
+                if (const auto overflow = push(cache, index, static_cast<Node *>(p)); overflow) {
+                    const auto head = reinterpret_cast<batch *>(overflow);
+                    head->next_batch = std::exchange(batches, head);
+                }
+            }
+            release(cache);
+            while (batches) {
+                const auto head = std::exchange(batches, batches->next_batch);
+                depot_give_batch(index, reinterpret_cast<Node *>(head));
+            }
+        }
+
+        static processor_caches &instance() noexcept {
+            static processor_caches instance{};
+            return instance;
+        }
+    private:
+        const uint32_t m_count;
+        const std::unique_ptr<processor_cache[]> m_caches;
+
+        static Node *pop(processor_cache &cache, const size_t index) noexcept {
+            auto &bin = cache.bins[index];
+            const auto node = bin.head;
+            if (!node) return nullptr;
+            bin.head = node->next;
+            --bin.count;
+            return node;
+        }
+
+        // keeps the rest of a depot list in the cache if its bin is still empty, or gives it straight back
+        void stash(const size_t index, Node *const list, const uint32_t count) noexcept {
+            if (!list) return;
+            auto &cache = acquire();
+            auto &bin = cache.bins[index];
+            const auto empty = !bin.head;
+            if (empty) bin.head = list, bin.count = count;
+            release(cache);
+            if (!empty) depot_give(index, list);
+        }
+
+        // returns a full batch to hand back to the depot once the cache holds more than two
+        static Node *push(processor_cache &cache, const size_t index, Node *const node) noexcept {
+            auto &bin = cache.bins[index];
+            node->next = bin.head;
+            bin.head = node;
+            if (const auto want = batch_count(index); ++bin.count > 2 * want) {
+                auto tail = node;
+                for (size_t i = 1; i < want; ++i) tail = tail->next;
+                bin.head = std::exchange(tail->next, nullptr);
+                bin.count -= uint32_t(want);
+                return node;
+            }
+            return nullptr;
+        }
+    };
+}
+
+namespace kls::pmr {
+    MemoryResource *per_processor_pool_resource() noexcept {
+        struct Resource : MemoryResource {
+            Resource() noexcept: MemoryResource(
+                    reinterpret_cast<FnAllocate>(&Resource::allocate_self),
+                    reinterpret_cast<FnDeallocate>(&Resource::deallocate_self), nullptr,
+                    reinterpret_cast<FnAllocateAtLeast>(&Resource::allocate_at_least_self),
+                    reinterpret_cast<FnTryResize>(&Resource::try_resize_self),
+                    reinterpret_cast<FnAllocateBatch>(&Resource::allocate_batch_self),
+                    reinterpret_cast<FnDeallocateBatch>(&Resource::deallocate_batch_self)
+            ) {}
+
+            void *allocate_self(size_t bytes, size_t alignment) { // NOLINT
+                if (!detail::pool::pooled(bytes, alignment))
+                    return new_delete_resource()->allocate(bytes, alignment);
+                if (const auto p = processor_caches::instance().allocate(detail::pool::class_of(bytes)); p) return p;
+                throw std::bad_alloc();
+            }
+
+            void deallocate_self(void *p, size_t bytes, size_t alignment) { // NOLINT
+                if (!detail::pool::pooled(bytes, alignment))
+                    return new_delete_resource()->deallocate(p, bytes, alignment);
+                processor_caches::instance().deallocate(p, detail::pool::class_of(bytes));
+            }
+
+            AllocationResult<void *> allocate_at_least_self(size_t bytes, size_t alignment) { // NOLINT
+                if (!detail::pool::pooled(bytes, alignment)) return {allocate_self(bytes, alignment), bytes};
+                const auto index = detail::pool::class_of(bytes);
+                return {allocate_self(bytes, alignment), detail::pool::class_size(index)};
+            }
+
+            bool try_resize_self(void *, size_t bytes, size_t new_bytes, size_t alignment) { // NOLINT
+                return detail::pool::pooled(bytes, alignment) && detail::pool::pooled(new_bytes, alignment) &&
+                       detail::pool::class_of(bytes) == detail::pool::class_of(new_bytes);
+            }
+
+            void allocate_batch_self(Span<void *> out, size_t bytes, size_t alignment) { // NOLINT
+                if (!detail::pool::pooled(bytes, alignment)) return allocate_each(out, bytes, alignment);
+                if (!processor_caches::instance().allocate_batch(out, detail::pool::class_of(bytes))) throw std::bad_alloc();
+            }
+
+            void deallocate_batch_self(Span<void *> ptrs, size_t bytes, size_t alignment) { // NOLINT
+                if (!detail::pool::pooled(bytes, alignment))
+                    return new_delete_resource()->deallocate_batch(ptrs, bytes, alignment);
+                processor_caches::instance().deallocate_batch(ptrs, detail::pool::class_of(bytes));
+            }
+        };
+        static Resource resource{};
+        return &resource;
+    }
+}
@@ -0,0 +1,389 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <new>
+#include <mutex>
+#include <utility>
+#include "kls/pmr/Pool.h"
+#include "kls/essential/Memory.h"
+
+namespace {
+    using namespace kls::pmr::detail::pool;
+
+    constexpr uintptr_t block_size = 4u << 20u; // 4MiB
+    constexpr uintptr_t block_mask = block_size - 1;
+    constexpr uintptr_t chunk_shl = 16u; // 64KiB, the granularity of runs
+
+    // the start of every block used for runs records the size class of each of its 64KiB chunks
+    struct block_header {
+        uint8_t chunk_class[block_size >> chunk_shl];
+    };
+
+    static_assert(class_count <= UINT8_MAX && sizeof(block_header) % alignof(std::max_align_t) == 0);
+
+    // a batch in the depot is a plain node list, with the batch chain threaded through the second word of the head
+    struct batch {
+        Node *next;
+        batch *next_batch;
+    };
+
+    class pool_host {
+        struct alignas(64) depot {
+            std::mutex lock;
+            batch *full{};
+            Node *loose{};
+            size_t loose_count{};
+            uintptr_t run_head{}, run_limit{};
+        };
+    public:
+        [[nodiscard]] Node *take(const size_t index, uint32_t &count) noexcept {
+            auto &d = m_depots[index];
+            const auto want = batch_count(index);
+            uintptr_t carve_begin;
+            size_t carved;
+            {
+                const std::lock_guard lock(d.lock);
+                if (d.full) {
+                    const auto ret = d.full;
+                    d.full = ret->next_batch;
+                    return (count = uint32_t(want), reinterpret_cast<Node *>(ret));
+                }
+                if (d.loose) {
+                    count = uint32_t(std::exchange(d.loose_count, 0));
+                    return std::exchange(d.loose, nullptr);
+                }
+                // the tail of the current run is handed out before a new run is taken, so a carve may come up short
+                // of a full batch, and the first run of a block loses room to the header
+                const auto size = class_size(index);
+                if (d.run_head + size > d.run_limit) {
+                    const auto run = take_run(index);
+                    if (!run) return (count = 0, nullptr);
+                    d.run_head = (run & block_mask) ? run : run + sizeof(block_header);
+                    d.run_limit = run + run_size(index);
+                }
+                carve_begin = d.run_head;
+                carved = std::min(want, size_t((d.run_limit - d.run_head) / size));
+                d.run_head += size * carved;
+            }
+            // link the freshly carved nodes outside the lock, nobody else can see them yet
+            const auto size = class_size(index);
+            for (size_t i = 0; i < carved; ++i) {
+                const auto node = reinterpret_cast<Node *>(carve_begin + i * size);
+                node->next = (i + 1 < carved) ? reinterpret_cast<Node *>(carve_begin + (i + 1) * size) : nullptr;
+            }
+            return (count = uint32_t(carved), reinterpret_cast<Node *>(carve_begin));
+        }
+
+        // the list must contain exactly batch_count(index) nodes
+        void give_batch(const size_t index, Node *const list) noexcept {
+            auto &d = m_depots[index];
+            const auto b = reinterpret_cast<batch *>(list);
+            const std::lock_guard lock(d.lock);
+            b->next_batch = d.full;
+            d.full = b;
+        }
+
+        void give_loose(const size_t index, Node *list) noexcept {
+            auto &d = m_depots[index];
+            const auto want = batch_count(index);
+            const std::lock_guard lock(d.lock);
+            while (list) {
+                const auto next = list->next;
+                list->next = d.loose;
+                d.loose = list;
+                if (++d.loose_count == want) {
+                    const auto b = reinterpret_cast<batch *>(std::exchange(d.loose, nullptr));
+                    b->next_batch = d.full;
+                    d.full = b;
+                    d.loose_count = 0;
+                }
+                list = next;
+            }
+        }
+
+        static pool_host &instance() noexcept {
+            static pool_host instance{};
+            return instance;
+        }
+    private:
+        depot m_depots[class_count];
+        std::mutex m_run_lock;
+        uintptr_t m_run_head{}, m_run_limit{};
+
+        // runs are never given back, the depots keep the nodes for reuse, 0 if the block host is exhausted
+        uintptr_t take_run(const size_t index) noexcept {
+            const auto size = run_size(index);
+            const std::lock_guard lock(m_run_lock);
+            if (m_run_head + size > m_run_limit) {
+                const auto block = kls::essential::rent_4m_block();
+                if (!block) return 0;
+                m_run_head = block;
+                m_run_limit = m_run_head + block_size;
+            }
+            const auto run = std::exchange(m_run_head, m_run_head + size);
+            const auto header = reinterpret_cast<block_header *>(run & ~block_mask);
+            for (auto i = run; i < run + size; i += uintptr_t(1) << chunk_shl)
+                header->chunk_class[(i & block_mask) >> chunk_shl] = uint8_t(index);
+            return run;
+        }
+    };
+
+    struct cache_bin {
+        Node *head;
+        uint32_t count;
+    };
+
+    // trivially destructible so that it stays usable while other thread_local objects are being destroyed
+    struct thread_cache {
+        cache_bin bins[class_count];
+        bool dead;
+    };
+
+    constinit thread_local thread_cache t_cache{};
+
+    struct cache_guard {
+        ~cache_guard() noexcept {
+            auto &host = pool_host::instance();
+            for (size_t i = 0; i < class_count; ++i) {
+                auto &bin = t_cache.bins[i];
+                if (bin.head) host.give_loose(i, std::exchange(bin.head, nullptr));
+                bin.count = 0;
+            }
+            t_cache.dead = true;
+        }
+    };
+
+    void register_cache() noexcept {
+        static thread_local cache_guard guard{};
+        (void) guard;
+    }
+}
+
+namespace kls::pmr::detail::pool {
+    Node *depot_take(const size_t index, uint32_t &count) noexcept { return pool_host::instance().take(index, count); }
+
+    void depot_give_batch(const size_t index, Node *const list) noexcept {
+        pool_host::instance().give_batch(index, list);
+    }
+
+    void depot_give(const size_t index, Node *const list) noexcept { pool_host::instance().give_loose(index, list); }
+
+    void *allocate(const size_t index) noexcept {
+        auto &bin = t_cache.bins[index];
+        if (const auto node = bin.head; node) {
+            bin.head = node->next;
+            --bin.count;
+            return node;
+        }
+        uint32_t count{};
+        const auto list = pool_host::instance().take(index, count);
+        if (!list) return nullptr;
+        if (t_cache.dead) {
+            // the thread is shutting down, keep one node and hand the rest back
+            if (list->next) pool_host::instance().give_loose(index, list->next);
+            return list;
+        }
+        register_cache();
+        bin.head = list->next;
+        bin.count = count - 1;
+        return list;
+    }
+
+    void deallocate(void *const p, const size_t index) noexcept {
+        auto &bin = t_cache.bins[index];
+        const auto node = static_cast<Node *>(p);
+        if (t_cache.dead) {
+            node->next = nullptr;
+            return pool_host::instance().give_loose(index, node);
+        }
+        if (!bin.head) register_cache();
+        node->next = bin.head;
+        bin.head = node;
+        // keep at most two batches around, and hand one back to the depot once exceeded
+        if (const auto want = batch_count(index); ++bin.count > 2 * want) {
+            auto tail = node;
+            for (size_t i = 1; i < want; ++i) tail = tail->next;
+            bin.head = std::exchange(tail->next, nullptr);
+            bin.count -= uint32_t(want);
+            pool_host::instance().give_batch(index, node);
+        }
+    }
+
+    bool allocate_batch(Span<void *> out, const size_t index) noexcept {
+        for (size_t i = 0; i < out.size(); ++i) {
+            if (out.data()[i] = allocate(index); !out.data()[i]) return deallocate_batch(out.keep_front(i), index), false;
+        }
+        return true;
+    }
+
+    void deallocate_batch(Span<void *> ptrs, const size_t index) noexcept {
+        for (const auto p: ptrs) deallocate(p, index);
+    }
+
+    size_t class_of_pointer(const void *p) noexcept {
+        const auto address = reinterpret_cast<uintptr_t>(p);
+        const auto header = reinterpret_cast<const block_header *>(address & ~block_mask);
+        return header->chunk_class[(address & block_mask) >> chunk_shl];
+    }
+}
+
+namespace kls::pmr {
+    UnsynchronizedPoolResource::UnsynchronizedPoolResource(MemoryResource *upstream) noexcept: MemoryResource(
+            reinterpret_cast<FnAllocate>(&UnsynchronizedPoolResource::allocate_self),
+            reinterpret_cast<FnDeallocate>(&UnsynchronizedPoolResource::deallocate_self), nullptr,
+            reinterpret_cast<FnAllocateAtLeast>(&UnsynchronizedPoolResource::allocate_at_least_self),
+            reinterpret_cast<FnTryResize>(&UnsynchronizedPoolResource::try_resize_self),
+            reinterpret_cast<FnAllocateBatch>(&UnsynchronizedPoolResource::allocate_batch_self),
+            reinterpret_cast<FnDeallocateBatch>(&UnsynchronizedPoolResource::deallocate_batch_self)
+    ), mUpstream(upstream) {}
+
+    UnsynchronizedPoolResource::~UnsynchronizedPoolResource() noexcept { release(); }
+
+    void UnsynchronizedPoolResource::release() noexcept {
+        while (mBlocks) {
+            const auto block = mBlocks;
+            mBlocks = *reinterpret_cast<uintptr_t *>(block);
+            essential::return_4m_block(block);
+        }
+        for (auto &list: mFree) list = nullptr;
+        mHead = mLimit = 0;
+    }
+
+    void *UnsynchronizedPoolResource::allocate_self(size_t bytes, size_t alignment) {
+        if (!detail::pool::pooled(bytes, alignment)) return mUpstream->allocate(bytes, alignment);
+        const auto index = detail::pool::class_of(bytes);
+        if (const auto node = mFree[index]; node) return (mFree[index] = node->next, node);
+        return carve(index);
+    }
+
+    void UnsynchronizedPoolResource::deallocate_self(void *p, size_t bytes, size_t alignment) {
+        if (!detail::pool::pooled(bytes, alignment)) return mUpstream->deallocate(p, bytes, alignment);
+        const auto index = detail::pool::class_of(bytes);
+        const auto node = static_cast<Node *>(p);
+        node->next = mFree[index];
+        mFree[index] = node;
+    }
+
+    AllocationResult<void *> UnsynchronizedPoolResource::allocate_at_least_self(size_t bytes, size_t alignment) {
+        if (!detail::pool::pooled(bytes, alignment)) return mUpstream->allocate_at_least(bytes, alignment);
+        const auto rounded = detail::pool::class_size(detail::pool::class_of(bytes));
+        return {allocate_self(rounded, alignment), rounded};
+    }
+
+    bool UnsynchronizedPoolResource::try_resize_self(void *p, size_t bytes, size_t new_bytes, size_t alignment) {
+        if (!detail::pool::pooled(bytes, alignment)) {
+            if (detail::pool::pooled(new_bytes, alignment)) return false;
+            if (new_bytes > bytes) return mUpstream->try_expand(p, bytes, new_bytes, alignment);
+            return mUpstream->try_shrink(p, bytes, new_bytes, alignment);
+        }
+        return detail::pool::pooled(new_bytes, alignment) &&
+               detail::pool::class_of(bytes) == detail::pool::class_of(new_bytes);
+    }
+
+    void UnsynchronizedPoolResource::allocate_batch_self(Span<void *> out, size_t bytes, size_t alignment) {
+        if (!detail::pool::pooled(bytes, alignment)) return mUpstream->allocate_batch(out, bytes, alignment);
+        const auto index = detail::pool::class_of(bytes);
+        auto &list = mFree[index];
+        for (size_t i = 0; i < out.size(); ++i) {
+            try {
+                out.data()[i] = list ? std::exchange(list, list->next) : carve(index);
+            } catch (...) {
+                deallocate_batch_self(out.keep_front(i), bytes, alignment);
+                throw;
+            }
+        }
+    }
+
+    void UnsynchronizedPoolResource::deallocate_batch_self(Span<void *> ptrs, size_t bytes, size_t alignment) {
+        if (!detail::pool::pooled(bytes, alignment)) return mUpstream->deallocate_batch(ptrs, bytes, alignment);
+        auto &list = mFree[detail::pool::class_of(bytes)];
+        for (const auto p: ptrs) {
+            const auto node = static_cast<Node *>(p);
+            node->next = list;
+            list = node;
+        }
+    }
+
+    void *UnsynchronizedPoolResource::carve(size_t index) {
+        const auto size = detail::pool::class_size(index);
+        if (mHead + size > mLimit) {
+            // the first max_align_t of each block links the blocks owned by this resource
+            const auto block = essential::rent_4m_block();
+            if (!block) throw std::bad_alloc();
+            *reinterpret_cast<uintptr_t *>(block) = mBlocks;
+            mBlocks = block;
+            mHead = block + alignof(std::max_align_t);
+            mLimit = block + block_size;
+        }
+        return reinterpret_cast<void *>(std::exchange(mHead, mHead + size));
+    }
+
+    MemoryResource *pool_resource() noexcept {
+        struct Resource : MemoryResource {
+            Resource() noexcept: MemoryResource(
+                    reinterpret_cast<FnAllocate>(&Resource::allocate_self),
+                    reinterpret_cast<FnDeallocate>(&Resource::deallocate_self), nullptr,
+                    reinterpret_cast<FnAllocateAtLeast>(&Resource::allocate_at_least_self),
+                    reinterpret_cast<FnTryResize>(&Resource::try_resize_self),
+                    reinterpret_cast<FnAllocateBatch>(&Resource::allocate_batch_self),
+                    reinterpret_cast<FnDeallocateBatch>(&Resource::deallocate_batch_self)
+            ) {}
+
+            void *allocate_self(size_t bytes, size_t alignment) { // NOLINT
+                if (!detail::pool::pooled(bytes, alignment))
+                    return new_delete_resource()->allocate(bytes, alignment);
+                if (const auto p = detail::pool::allocate(detail::pool::class_of(bytes)); p) return p;
+                throw std::bad_alloc();
+            }
+
+            void deallocate_self(void *p, size_t bytes, size_t alignment) { // NOLINT
+                if (!detail::pool::pooled(bytes, alignment))
+                    return new_delete_resource()->deallocate(p, bytes, alignment);
+                return detail::pool::deallocate(p, detail::pool::class_of(bytes));
+            }
+
+            AllocationResult<void *> allocate_at_least_self(size_t bytes, size_t alignment) { // NOLINT
+                if (!detail::pool::pooled(bytes, alignment)) return {allocate_self(bytes, alignment), bytes};
+                const auto index = detail::pool::class_of(bytes);
+                return {allocate_self(bytes, alignment), detail::pool::class_size(index)};
+            }
+
+            bool try_resize_self(void *, size_t bytes, size_t new_bytes, size_t alignment) { // NOLINT
+                return detail::pool::pooled(bytes, alignment) && detail::pool::pooled(new_bytes, alignment) &&
+                       detail::pool::class_of(bytes) == detail::pool::class_of(new_bytes);
+            }
+
+            void allocate_batch_self(Span<void *> out, size_t bytes, size_t alignment) { // NOLINT
+                if (!detail::pool::pooled(bytes, alignment)) return allocate_each(out, bytes, alignment);
+                if (!detail::pool::allocate_batch(out, detail::pool::class_of(bytes))) throw std::bad_alloc();
+            }
+
+            void deallocate_batch_self(Span<void *> ptrs, size_t bytes, size_t alignment) { // NOLINT
+                if (!detail::pool::pooled(bytes, alignment))
+                    return new_delete_resource()->deallocate_batch(ptrs, bytes, alignment);
+                detail::pool::deallocate_batch(ptrs, detail::pool::class_of(bytes));
+            }
+        };
+        static Resource resource{};
+        return &resource;
+    }
+}
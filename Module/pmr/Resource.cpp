@@ -21,10 +21,18 @@
 */
 
 #include <new>
+#include <atomic>
 #include "kls/pmr/Resource.h"
 
+namespace {
+    std::atomic<kls::pmr::MemoryResource *> &default_slot() noexcept {
+        static std::atomic<kls::pmr::MemoryResource *> slot{kls::pmr::new_delete_resource()};
+        return slot;
+    }
+}
+
 namespace kls::pmr {
-    MemoryResource *default_resource() noexcept {
+    MemoryResource *new_delete_resource() noexcept {
         struct Resource : MemoryResource {
             Resource() noexcept: MemoryResource(
                     reinterpret_cast<FnAllocate>(&Resource::allocate_self),
@@ -46,4 +54,11 @@ namespace kls::pmr {
         static Resource resource{};
         return &resource;
     }
+
+    MemoryResource *default_resource() noexcept { return default_slot().load(std::memory_order_acquire); }
+
+    MemoryResource *set_default_resource(MemoryResource *resource) noexcept {
+        if (!resource) resource = new_delete_resource();
+        return default_slot().exchange(resource, std::memory_order_acq_rel);
+    }
 }
\ No newline at end of file
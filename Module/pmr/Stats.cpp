@@ -0,0 +1,229 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <bit>
+#include <mutex>
+#include <algorithm>
+#include "kls/Format.h"
+#include "kls/pmr/Stats.h"
+
+namespace {
+    size_t size_bucket(size_t bytes) noexcept {
+        const auto bucket = bytes > 1 ? size_t(std::bit_width(bytes - 1)) : 0;
+        return std::min(bucket, kls::pmr::ResourceStats::size_buckets - 1);
+    }
+
+    size_t align_bucket(size_t align) noexcept {
+        const auto bucket = align > 1 ? size_t(std::bit_width(align - 1)) : 0;
+        return std::min(bucket, kls::pmr::ResourceStats::align_buckets - 1);
+    }
+
+    // a shard owned by the current thread needs no read-modify-write, as nobody else writes to it
+    template<class T>
+    void bump(std::atomic<T> &counter, T value, bool exclusive) noexcept {
+        if (exclusive)
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        else
+            counter.fetch_add(value, std::memory_order_relaxed);
+    }
+}
+
+namespace kls::pmr {
+    struct StatsRegistry {
+        std::mutex lock;
+        StatsResource *head{};
+
+        void add(StatsResource *res) noexcept {
+            const std::lock_guard guard(lock);
+            res->mNext = head;
+            if (head) head->mPrev = res;
+            head = res;
+        }
+
+        void remove(StatsResource *res) noexcept {
+            const std::lock_guard guard(lock);
+            if (res->mPrev) res->mPrev->mNext = res->mNext; else head = res->mNext;
+            if (res->mNext) res->mNext->mPrev = res->mPrev;
+        }
+
+        template<class Fn>
+        void each(Fn &&fn) {
+            const std::lock_guard guard(lock);
+            for (auto it = head; it; it = it->mNext) fn(*it);
+        }
+
+        static StatsRegistry &instance() noexcept {
+            static StatsRegistry instance{};
+            return instance;
+        }
+    };
+
+    StatsResource::StatsResource(std::string name, MemoryResource *upstream): MemoryResource(
+            reinterpret_cast<FnAllocate>(&StatsResource::allocate_self),
+            reinterpret_cast<FnDeallocate>(&StatsResource::deallocate_self), nullptr,
+            reinterpret_cast<FnAllocateAtLeast>(&StatsResource::allocate_at_least_self),
+            reinterpret_cast<FnTryResize>(&StatsResource::try_resize_self),
+            reinterpret_cast<FnAllocateBatch>(&StatsResource::allocate_batch_self),
+            reinterpret_cast<FnDeallocateBatch>(&StatsResource::deallocate_batch_self)
+    ), mName(std::move(name)), mUpstream(upstream) { StatsRegistry::instance().add(this); }
+
+    StatsResource::~StatsResource() noexcept { StatsRegistry::instance().remove(this); }
+
+    size_t StatsResource::shard_index() noexcept {
+        static std::atomic_bool claimed[exclusive_shards]{};
+        struct Claim {
+            size_t index{exclusive_shards};
+
+            Claim() noexcept {
+                for (size_t i = 0; i < exclusive_shards; ++i) {
+                    if (bool expect = false; claimed[i].compare_exchange_strong(expect, true)) {
+                        index = i;
+                        return;
+                    }
+                }
+            }
+
+            ~Claim() noexcept { if (index < exclusive_shards) claimed[index].store(false); }
+        };
+        static thread_local const Claim claim{};
+        return claim.index;
+    }
+
+    void *StatsResource::allocate_self(size_t bytes, size_t alignment) {
+        const auto result = mUpstream->allocate(bytes, alignment);
+        record_allocation(bytes, alignment);
+        return result;
+    }
+
+    // only the requested size is reported, so that deallocation always passes back the size recorded here
+    // the slack of the upstream block stays reachable through try_expand
+    AllocationResult<void *> StatsResource::allocate_at_least_self(size_t bytes, size_t alignment) {
+        const auto result = mUpstream->allocate_at_least(bytes, alignment);
+        record_allocation(bytes, alignment);
+        return {result.ptr, bytes};
+    }
+
+    bool StatsResource::try_resize_self(void *p, size_t bytes, size_t new_bytes, size_t alignment) {
+        const auto done = new_bytes > bytes ? mUpstream->try_expand(p, bytes, new_bytes, alignment) :
+                          mUpstream->try_shrink(p, bytes, new_bytes, alignment);
+        if (done) {
+            const auto index = shard_index();
+            record(mShards[index], int64_t(new_bytes) - int64_t(bytes), index < exclusive_shards);
+        }
+        return done;
+    }
+
+    void StatsResource::record_allocation(size_t bytes, size_t alignment, size_t count) noexcept {
+        const auto index = shard_index();
+        const auto exclusive = index < exclusive_shards;
+        auto &shard = mShards[index];
+        bump(shard.sizes[size_bucket(bytes)], uint64_t(count), exclusive);
+        bump(shard.alignments[align_bucket(alignment)], uint64_t(count), exclusive);
+        record(shard, int64_t(bytes * count), exclusive);
+    }
+
+    void StatsResource::record_deallocation(size_t bytes, size_t count) noexcept {
+        const auto index = shard_index();
+        const auto exclusive = index < exclusive_shards;
+        auto &shard = mShards[index];
+        bump(shard.deallocations, uint64_t(count), exclusive);
+        record(shard, -int64_t(bytes * count), exclusive);
+    }
+
+    void StatsResource::deallocate_self(void *p, size_t bytes, size_t alignment) {
+        mUpstream->deallocate(p, bytes, alignment);
+        record_deallocation(bytes);
+    }
+
+    void StatsResource::allocate_batch_self(Span<void *> out, size_t bytes, size_t alignment) {
+        mUpstream->allocate_batch(out, bytes, alignment);
+        record_allocation(bytes, alignment, out.size());
+    }
+
+    void StatsResource::deallocate_batch_self(Span<void *> ptrs, size_t bytes, size_t alignment) {
+        mUpstream->deallocate_batch(ptrs, bytes, alignment);
+        record_deallocation(bytes, ptrs.size());
+    }
+
+    // the shared total is only touched once a shard has moved by flush_bytes, which small allocations rarely do
+    void StatsResource::record(Shard &shard, int64_t delta, bool exclusive) noexcept {
+        bump(shard.live, delta, exclusive);
+        bump(shard.pending, delta, exclusive);
+        const auto pending = shard.pending.load(std::memory_order_relaxed);
+        if (pending < flush_bytes && pending > -flush_bytes) return;
+        const auto flushed = shard.pending.exchange(0, std::memory_order_relaxed);
+        const auto published = mPublished.fetch_add(flushed, std::memory_order_relaxed) + flushed;
+        if (flushed > 0) raise_peak(published);
+    }
+
+    void StatsResource::raise_peak(int64_t live) const noexcept {
+        auto peak = mPeak.load(std::memory_order_relaxed);
+        while (live > peak && !mPeak.compare_exchange_weak(peak, live, std::memory_order_relaxed));
+    }
+
+    ResourceStats StatsResource::stats() const noexcept {
+        ResourceStats result{};
+        for (auto &shard: mShards) {
+            result.live_bytes += shard.live.load(std::memory_order_relaxed);
+            result.deallocations += shard.deallocations.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < ResourceStats::size_buckets; ++i) {
+                const auto count = shard.sizes[i].load(std::memory_order_relaxed);
+                result.sizes[i] += count;
+                result.allocations += count;
+            }
+            for (size_t i = 0; i < ResourceStats::align_buckets; ++i)
+                result.alignments[i] += shard.alignments[i].load(std::memory_order_relaxed);
+        }
+        raise_peak(result.live_bytes);
+        result.peak_bytes = mPeak.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void visit_stats_resources(const std::function<void(const StatsResource &)> &fn) {
+        StatsRegistry::instance().each(fn);
+    }
+
+    std::string dump_stats_resources() {
+        std::string result{};
+        visit_stats_resources([&result](const StatsResource &res) {
+            const auto stats = res.stats();
+            result += format(
+                    "{}: allocations={} deallocations={} live={}B peak={}B\n",
+                    res.name(), stats.allocations, stats.deallocations, stats.live_bytes, stats.peak_bytes
+            );
+            result += "  sizes:";
+            for (size_t i = 0; i < ResourceStats::size_buckets; ++i) {
+                if (!stats.sizes[i]) continue;
+                const auto last = i + 1 == ResourceStats::size_buckets;
+                result += format(" {}{}={}", last ? ">" : "<=", size_t(1) << (last ? i - 1 : i), stats.sizes[i]);
+            }
+            result += "\n  alignments:";
+            for (size_t i = 0; i < ResourceStats::align_buckets; ++i) {
+                if (!stats.alignments[i]) continue;
+                const auto last = i + 1 == ResourceStats::align_buckets;
+                result += format(" {}{}={}", last ? ">" : "", size_t(1) << (last ? i - 1 : i), stats.alignments[i]);
+            }
+            result += '\n';
+        });
+        return result;
+    }
+}
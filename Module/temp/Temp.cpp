@@ -20,7 +20,9 @@
 * SOFTWARE.
 */
 
+#include <new>
 #include <atomic>
+#include <algorithm>
 #include "kls/temp/Temp.h"
 
 namespace {
@@ -30,8 +32,10 @@ namespace {
         std::atomic_int32_t flying{0};
     };
 
+    // nullptr if the block host is exhausted
     header *fetch() noexcept {
-        return std::construct_at(reinterpret_cast<header *>(kls::essential::rent_4m_block()));
+        const auto block = kls::essential::rent_4m_block();
+        return block ? std::construct_at(reinterpret_cast<header *>(block)) : nullptr;
     }
 
     void release(header *const blk) noexcept {
@@ -58,8 +62,9 @@ namespace {
             return false;
         }
 
+        // without a block the head is placed at the end, so that every allocation fails
         void reset(header *const other) noexcept {
-            current = other, head = alloc_start, count = 0;
+            current = other, head = other ? alloc_start : block_size, count = 0;
         }
 
         [[nodiscard]] void *allocate(const uintptr_t size) noexcept {
@@ -72,57 +77,171 @@ namespace {
             }
             return nullptr;
         }
+
+        // bumps once for as many of the n requested blocks as fit in the current block
+        [[nodiscard]] size_t allocate_batch(const uintptr_t size, void **const out, const size_t n) noexcept {
+            if (!current) return 0;
+            const auto aligned = std::max(max_align(size), uintptr_t(alignof(std::max_align_t)));
+            const auto fit = std::min(uintptr_t(n), (block_size - 1 - head) / aligned);
+            const auto base = reinterpret_cast<uintptr_t>(current) + head;
+            for (uintptr_t i = 0; i < fit; ++i) out[i] = reinterpret_cast<void *>(base + i * aligned);
+            head += fit * aligned;
+            count += int32_t(fit);
+            return fit;
+        }
+
+        // only the latest allocation made from the block can change its size in place
+        [[nodiscard]] bool resize(void *const p, const uintptr_t size, const uintptr_t new_size) noexcept {
+            if (!current) return false;
+            const auto start = head - max_align(size);
+            if (reinterpret_cast<uintptr_t>(current) + start != reinterpret_cast<uintptr_t>(p)) return false;
+            if (const auto expected = start + max_align(new_size); expected < block_size) {
+                head = expected;
+                return true;
+            }
+            return false;
+        }
     };
 
     constexpr uintptr_t temp_max_span = 1u << 18u;
 
-    [[nodiscard]] void *allocate_impl(const uintptr_t size) noexcept {
-        struct local final {
-            allocation alloc{};
+    struct local final {
+        allocation alloc{};
 
-            local() noexcept { reset(); }
+        local() noexcept { reset(fetch()); }
 
-            ~local() noexcept { reset(nullptr); }
+        ~local() noexcept { reset(nullptr); }
 
-            void reset(header *const next = fetch()) noexcept {
-                if (header *last = nullptr; alloc.flush(last)) {
-                    if (last) release(last);
-                }
-                alloc.reset(next);
+        void reset(header *const next) noexcept {
+            if (header *last = nullptr; alloc.flush(last)) {
+                if (last) release(last);
             }
-        };
-        static const thread_local auto o = std::make_unique<local>();
-        for (;;) if (const auto ret = o->alloc.allocate(size); ret) return ret; else o->reset();
+            alloc.reset(next);
+        }
+
+        // moves on to a new block, the current one is kept if none can be rented
+        [[nodiscard]] bool refill() noexcept {
+            const auto next = fetch();
+            if (next) reset(next);
+            return next != nullptr;
+        }
+
+        static local &instance() noexcept {
+            static const thread_local auto o = std::make_unique<local>();
+            return *o;
+        }
+    };
+
+    // nullptr if the block host is exhausted
+    [[nodiscard]] void *allocate_impl(const uintptr_t size) noexcept {
+        auto &o = local::instance();
+        for (;;) {
+            if (const auto ret = o.alloc.allocate(size); ret) return ret;
+            if (!o.refill()) return nullptr;
+        }
     }
 
-    void deallocate_impl(void *const mem) noexcept {
+    [[nodiscard]] bool resize_impl(void *const mem, const uintptr_t size, const uintptr_t new_size) noexcept {
+        return local::instance().alloc.resize(mem, size, new_size);
+    }
+
+    [[nodiscard]] header *header_of(void *const mem) noexcept {
         static constexpr uintptr_t rev = 0b11'1111'1111'1111'1111'1111;
         static constexpr uintptr_t mask = ~rev;
+        return reinterpret_cast<header *>(reinterpret_cast<uintptr_t>(mem) & mask);
+    }
+
+    void drop(header *const header, const int32_t count) noexcept {
+        if (header->flying.fetch_sub(count, std::memory_order_seq_cst) == count) release(header);
+    }
+
+    void deallocate_impl(void *const mem) noexcept {
         if (mem == nullptr) return;
-        const auto base = reinterpret_cast<uintptr_t>(mem) & mask;
-        const auto header = reinterpret_cast<struct header *>(base);
-        if (header->flying.fetch_sub(1, std::memory_order_seq_cst) == 1) release(header);
+        drop(header_of(mem), 1);
+    }
+
+    // consecutive blocks from the same 4MiB block are released with one atomic operation
+    void deallocate_batch_impl(void *const *const mem, const size_t n) noexcept {
+        header *run = nullptr;
+        int32_t count = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (mem[i] == nullptr) continue;
+            if (const auto header = header_of(mem[i]); header != run) {
+                if (run) drop(run, count);
+                run = header, count = 0;
+            }
+            ++count;
+        }
+        if (run) drop(run, count);
+    }
+
+    // false with the blocks already handed out given back if the block host is exhausted
+    [[nodiscard]] bool allocate_batch_impl(const uintptr_t size, void **const out, const size_t n) noexcept {
+        auto &o = local::instance();
+        for (size_t filled = 0;;) {
+            if (filled += o.alloc.allocate_batch(size, out + filled, n - filled); filled == n) return true;
+            if (!o.refill()) return deallocate_batch_impl(out, filled), false;
+        }
     }
 }
 
 namespace kls::temp {
+    void *allocate(size_t bytes, size_t align) {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__ || bytes > temp_max_span)
+            return ::operator new(bytes, std::align_val_t{align});
+        if (const auto p = allocate_impl(bytes); p) return p;
+        throw std::bad_alloc();
+    }
+
+    void deallocate(void *p, size_t bytes, size_t align) noexcept {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__ || bytes > temp_max_span)
+            return ::operator delete(p, bytes, std::align_val_t{align});
+        return deallocate_impl(p);
+    }
+
     pmr::MemoryResource *resource() noexcept {
         struct Resource : pmr::MemoryResource {
             Resource() noexcept: MemoryResource(
                     reinterpret_cast<FnAllocate>(&Resource::allocate_self),
-                    reinterpret_cast<FnDeallocate>(&Resource::deallocate_self)
+                    reinterpret_cast<FnDeallocate>(&Resource::deallocate_self), nullptr,
+                    reinterpret_cast<FnAllocateAtLeast>(&Resource::allocate_at_least_self),
+                    reinterpret_cast<FnTryResize>(&Resource::try_resize_self),
+                    reinterpret_cast<FnAllocateBatch>(&Resource::allocate_batch_self),
+                    reinterpret_cast<FnDeallocateBatch>(&Resource::deallocate_batch_self)
             ) {}
 
-            void *allocate_self(size_t bytes, size_t alignment) { // NOLINT
-                if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__ || bytes > temp_max_span)
-                    return ::operator new(bytes, std::align_val_t{alignment});
-                return allocate_impl(bytes);
+            static bool bumped(size_t bytes, size_t alignment) noexcept {
+                return alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ && bytes <= temp_max_span;
             }
 
+            void *allocate_self(size_t bytes, size_t alignment) { return temp::allocate(bytes, alignment); } // NOLINT
+
             void deallocate_self(void *p, size_t bytes, size_t alignment) { // NOLINT
-                if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__ || bytes > temp_max_span)
-                    return ::operator delete(p, bytes, std::align_val_t{alignment});
-                return deallocate_impl(p);
+                return temp::deallocate(p, bytes, alignment);
+            }
+
+            pmr::AllocationResult<void *> allocate_at_least_self(size_t bytes, size_t alignment) { // NOLINT
+                if (!bumped(bytes, alignment)) return {temp::allocate(bytes, alignment), bytes};
+                const auto rounded = max_align(bytes);
+                return {temp::allocate(rounded, alignment), rounded};
+            }
+
+            bool try_resize_self(void *p, size_t bytes, size_t new_bytes, size_t alignment) { // NOLINT
+                if (!bumped(bytes, alignment) || !bumped(new_bytes, alignment)) return false;
+                return resize_impl(p, bytes, new_bytes);
+            }
+
+            void allocate_batch_self(Span<void *> out, size_t bytes, size_t alignment) { // NOLINT
+                if (!bumped(bytes, alignment)) return allocate_each(out, bytes, alignment);
+                if (!allocate_batch_impl(bytes, out.data(), out.size())) throw std::bad_alloc();
+            }
+
+            void deallocate_batch_self(Span<void *> ptrs, size_t bytes, size_t alignment) { // NOLINT
+                if (!bumped(bytes, alignment)) {
+                    for (const auto p: ptrs) ::operator delete(p, bytes, std::align_val_t{alignment});
+                    return;
+                }
+                deallocate_batch_impl(ptrs.data(), ptrs.size());
             }
         };
         static Resource resource{};
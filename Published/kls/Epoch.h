@@ -0,0 +1,111 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace kls {
+    namespace detail {
+        struct EpochBatch;
+        struct EpochRecord;
+    }
+
+    /// <summary>
+    /// Epoch based reclamation domain
+    /// Readers pin the domain while they hold pointers into shared structures, objects unlinked from those structures
+    /// are retired and reclaimed once no reader pinned at the time of the unlink is left
+    /// Retired objects are batched per thread, a batch is reclaimed at the next quiescent point of the thread that
+    /// filled it, or, for a deferred domain, only when collect() is called
+    /// </summary>
+    class EpochDomain {
+    public:
+        class Guard {
+        public:
+            Guard(Guard &&o) noexcept: mRecord(std::exchange(o.mRecord, nullptr)) {}
+            Guard &operator=(Guard &&) = delete;
+            ~Guard() noexcept { if (mRecord) unpin(mRecord); }
+        private:
+            friend class EpochDomain;
+            explicit Guard(detail::EpochRecord *record) noexcept: mRecord(record) {}
+            detail::EpochRecord *mRecord;
+        };
+
+        /// <summary>
+        /// Creates a domain, a deferred domain leaves all reclamation to collect() so that it can run on a chosen thread
+        /// </summary>
+        explicit EpochDomain(bool deferred = false) noexcept: mDeferred(deferred) {}
+        EpochDomain(const EpochDomain &) = delete;
+        EpochDomain &operator=(const EpochDomain &) = delete;
+
+        /// <summary>
+        /// Reclaims everything still retired, every other thread that used the domain must have exited
+        /// </summary>
+        ~EpochDomain();
+
+        /// <summary>
+        /// Enters a read side critical section, pins nest
+        /// </summary>
+        [[nodiscard]] Guard pin();
+
+        /// <summary>
+        /// Schedules the object to be reclaimed once no reader can hold a reference to it anymore
+        /// The object must already be unreachable for readers that pin from now on
+        /// </summary>
+        void retire(void *object, void (*reclaim)(void *object) noexcept);
+
+        template<class T>
+        void retire(T *object) { retire(object, [](void *p) noexcept { delete static_cast<T *>(p); }); }
+
+        /// <summary>
+        /// Marks a quiescent point of the calling thread, and reclaims what became safe unless the domain is deferred
+        /// </summary>
+        void quiesce();
+
+        /// <summary>
+        /// Reclaims the batches handed to the domain, by a deferred domain or by threads that have exited
+        /// </summary>
+        /// <returns> The number of objects reclaimed </returns>
+        size_t collect() noexcept;
+
+        /// <summary>
+        /// The process wide domain
+        /// </summary>
+        static EpochDomain &global() noexcept;
+    private:
+        std::atomic<uint64_t> mEpoch{1};
+        std::atomic<detail::EpochRecord *> mRecords{};
+        std::atomic<detail::EpochBatch *> mShared{};
+        const bool mDeferred;
+
+        detail::EpochRecord *local();
+        detail::EpochRecord *acquire();
+        void release(detail::EpochRecord *record) noexcept;
+        void seal(detail::EpochRecord *record) noexcept;
+        void reclaim(detail::EpochRecord *record) noexcept;
+        void share(detail::EpochBatch *head, detail::EpochBatch *tail) noexcept;
+        bool try_advance() noexcept;
+        static void unpin(detail::EpochRecord *record) noexcept;
+    };
+}
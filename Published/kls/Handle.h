@@ -23,9 +23,13 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
+#include <memory>
 #include <utility>
 #include <concepts>
 #include <type_traits>
+#include "kls/Epoch.h"
+#include "kls/pmr/Pool.h"
 
 namespace kls {
     template<class T>
@@ -37,46 +41,247 @@ namespace kls {
         std::is_trivially_destructible_v<T>;
     };
 
+    /// <summary>
+    /// A destructor functor that carries no state, handles using it do not need a control block until duplicated
+    /// </summary>
+    template<class Fn>
+    concept StatelessHandleDestructor = std::is_empty_v<std::decay_t<Fn>> &&
+                                        std::is_default_constructible_v<std::decay_t<Fn>>;
+
+    /// <summary>
+    /// Destructor adaptor, the last close retires the control block into an EpochDomain instead of destroying it
+    /// inline, and the wrapped destructor runs when the domain reclaims it
+    /// </summary>
+    template<class Fn>
+    struct RetiredDestructor {
+        [[no_unique_address]] Fn fn;
+        EpochDomain *domain;
+
+        template<class T>
+        void operator()(T &value) noexcept { fn(value); }
+    };
+
+    template<class Fn>
+    RetiredDestructor<std::decay_t<Fn>> retired(Fn &&fn, EpochDomain &domain = EpochDomain::global()) {
+        return {std::forward<Fn>(fn), &domain};
+    }
+
+    class BiasedHandleCount;
+
     namespace detail {
-        class HandleControl {
-            using BaseDestruct = void (*)(void *base, void *data) noexcept;
-        public:
-            void acquire() noexcept { mCount.fetch_add(1); }
+        struct HandleThread {
+            uint64_t id;
+            std::atomic<BiasedHandleCount *> queue;
+            HandleThread *next;
+        };
+    }
 
-            void release(void *data) noexcept {
-                if (const auto result = mCount.fetch_sub(1); result == 1) {
-                    mBaseDestruct(mBasePointer, data);
-                }
+    /// <summary>
+    /// Reference counting policy of a handle control block
+    /// decrement() returns true when the last reference is gone, reclaim is for policies that can observe the last
+    /// release outside of decrement()
+    /// </summary>
+    template<class C>
+    concept HandleCounting = requires(C &c) {
+        { c.increment() } noexcept;
+        { c.decrement() } noexcept -> std::same_as<bool>;
+    } && std::is_nothrow_constructible_v<C, int, void (*)(C *) noexcept>;
+
+    /// <summary>
+    /// Thread safe counting, relaxed on increment as a duplicate is always made from a live reference
+    /// </summary>
+    class AtomicHandleCount {
+    public:
+        AtomicHandleCount(int count, void (*)(AtomicHandleCount *) noexcept) noexcept: mCount(count) {}
+
+        void increment() noexcept { mCount.fetch_add(1, std::memory_order_relaxed); }
+
+        bool decrement() noexcept {
+            if (mCount.fetch_sub(1, std::memory_order_release) != 1) return false;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return true;
+        }
+    private:
+        std::atomic_int mCount;
+    };
+
+    /// <summary>
+    /// Plain counting, for handles that are never duplicated or closed concurrently
+    /// </summary>
+    class LocalHandleCount {
+    public:
+        LocalHandleCount(int count, void (*)(LocalHandleCount *) noexcept) noexcept: mCount(count) {}
+
+        void increment() noexcept { ++mCount; }
+
+        bool decrement() noexcept { return --mCount == 0; }
+    private:
+        int mCount;
+    };
+
+    /// <summary>
+    /// Biased counting, the thread that created the control block counts without atomic operations
+    /// References released on other threads beyond what they acquired are handed back to the owner, which merges
+    /// the two counts on its next release or when it exits, so the last close may be deferred until then
+    /// A deferred close has no handle at hand, its destructor gets the value the control block was created with
+    /// </summary>
+    class BiasedHandleCount {
+    public:
+        using Reclaim = void (*)(BiasedHandleCount *count) noexcept;
+
+        BiasedHandleCount(int count, Reclaim reclaim) noexcept: mReclaim(reclaim) {
+            if (const auto self = enrolled(); self != exited) mOwner = self, mBiased = count;
+            else mShared.store(count * unit | merged, std::memory_order_relaxed);
+        }
+
+        void increment() noexcept {
+            if (biased()) ++mBiased; else mShared.fetch_add(unit, std::memory_order_relaxed);
+        }
+
+        bool decrement() noexcept {
+            if (tThread.queue.load(std::memory_order_relaxed)) drain();
+            if (!biased()) return release_shared();
+            if (--mBiased) return false;
+            // from here on every thread counts on the shared word
+            return mShared.fetch_or(merged, std::memory_order_acq_rel) == 0;
+        }
+    private:
+        // the shared word holds a signed count in units of 4, and the merged and queued flags
+        static constexpr intptr_t merged = 1;
+        static constexpr intptr_t queued = 2;
+        static constexpr intptr_t unit = 4;
+        static constexpr uint64_t exited = ~uint64_t(0);
+        static inline constinit thread_local detail::HandleThread tThread{};
+
+        uint64_t mOwner{};
+        int mBiased{};
+        std::atomic<intptr_t> mShared{0};
+        Reclaim mReclaim;
+        BiasedHandleCount *mNext{};
+
+        static uint64_t enroll() noexcept;
+
+        static uint64_t enrolled() noexcept { return tThread.id ? tThread.id : enroll(); }
+
+        bool biased() const noexcept {
+            return mOwner == tThread.id && !(mShared.load(std::memory_order_relaxed) & merged);
+        }
+
+        bool release_shared() noexcept {
+            const auto next = mShared.fetch_sub(unit, std::memory_order_acq_rel) - unit;
+            if (next == merged) return true;
+            // released a reference that the owner counted, the owner has to merge before the count is exact
+            if (next < 0 && !(next & (merged | queued))) {
+                if (!(mShared.fetch_or(queued, std::memory_order_acq_rel) & queued)) hand_over();
             }
+            return false;
+        }
+
+        // called by the owner, or by any thread once the owner has exited
+        void merge() noexcept {
+            const auto flag = (mShared.load(std::memory_order_relaxed) & merged) ? 0 : merged;
+            const auto delta = intptr_t(std::exchange(mBiased, 0)) * unit - queued + flag;
+            if (mShared.fetch_add(delta, std::memory_order_acq_rel) + delta == merged) mReclaim(this);
+        }
+
+        static void drain() noexcept {
+            auto it = tThread.queue.exchange(nullptr, std::memory_order_acquire);
+            while (it) std::exchange(it, it->mNext)->merge();
+        }
+
+        void hand_over() noexcept;
+    };
+
+    namespace detail {
+        template<class Counting>
+        class HandleControl : Counting {
+        public:
+            // value is the closing handle's value, or nullptr when the last close is observed away from any handle
+            using Destruct = void (*)(HandleControl *control, const void *value) noexcept;
+
+            // describes a handle whose control block has not been created yet
+            struct Inline {
+                void (*destruct)(void *data) noexcept;
+                HandleControl *(*promote)(const void *value);
+                void (*discard)(HandleControl *control) noexcept;
+            };
+
+            void acquire() noexcept { Counting::increment(); }
+
+            void release(const void *value) noexcept { if (Counting::decrement()) mDestruct(this, value); }
 
             template<class T, class Fn>
             requires requires(T &h, Fn fn) {
                 { fn(h) };
                 noexcept(fn(h));
             }
-            static HandleControl *make(Fn &&destruct);
+            static HandleControl *make(pmr::MemoryResource *resource, Fn &&destruct, const T &value, int count = 1);
+
+            template<class T, class Fn>
+            requires StatelessHandleDestructor<Fn>
+            static const Inline *make_inline() noexcept;
+        protected:
+            HandleControl(Destruct destruct, int count) noexcept:
+                    Counting(count, &HandleControl::reclaim), mDestruct(destruct) {}
         private:
-            void *mBasePointer{};
-            BaseDestruct mBaseDestruct{};
-            std::atomic_int mCount{1};
+            Destruct mDestruct;
+
+            static void reclaim(Counting *count) noexcept {
+                const auto self = static_cast<HandleControl *>(count);
+                self->mDestruct(self, nullptr);
+            }
         };
+
+        template<class T, class FnConcrete, class Counting>
+        struct HandleControlBlock;
     }
 
-    template<class T> requires TrivialManipulableData<T>
+    /// <summary>
+    /// Handle to a trivially copyable value whose destructor is shared by all duplicates
+    /// Counting selects how duplicates are counted, see AtomicHandleCount, LocalHandleCount and BiasedHandleCount
+    /// </summary>
+    template<class T, class Counting = AtomicHandleCount> requires TrivialManipulableData<T> && HandleCounting<Counting>
     class Handle {
+        using Control = detail::HandleControl<Counting>;
     public:
         friend struct HandleAccess;
-        friend class kls::detail::HandleControl;
+        friend class detail::HandleControl<Counting>;
+
+        /// <summary>
+        /// Creates a handle whose control block comes from pmr::pool_resource()
+        /// If the destructor is stateless, the control block is only created once the handle is copied or duplicated
+        /// </summary>
+        template<class Fn, class ...Ts>
+        requires (!std::same_as<std::remove_cvref_t<Fn>, Handle>) &&
+                 (!std::same_as<std::remove_cvref_t<Fn>, std::allocator_arg_t>)
+        explicit Handle(Fn &&destruct, Ts &&... args): mValue(std::forward<Ts>(args)...) {
+            if constexpr (StatelessHandleDestructor<Fn>)
+                mControl.store(reinterpret_cast<uintptr_t>(Control::template make_inline<T, Fn>()) | inline_tag);
+            else
+                mControl.store(to_word(Control::make(pmr::pool_resource(), std::forward<Fn>(destruct), mValue)));
+        }
 
+        /// <summary>
+        /// Creates a handle whose control block is allocated from the given resource
+        /// </summary>
         template<class Fn, class ...Ts>
-        explicit Handle(Fn &&destruct, Ts &&... args):
-                mControl(detail::HandleControl::make<T, Fn>(std::forward<Fn>(destruct))),
-                mValue(std::forward<Ts>(args)...) {}
-        Handle(const Handle &o) noexcept = default;
-        Handle &operator=(const Handle &o) noexcept = default;
-        Handle(Handle &&o) noexcept: mValue(o.mValue), mControl(o.mControl) { o.mControl = nullptr; }
+        Handle(std::allocator_arg_t, pmr::MemoryResource *resource, Fn &&destruct, Ts &&... args):
+                mValue(std::forward<Ts>(args)...),
+                mControl(to_word(Control::make(resource, std::forward<Fn>(destruct), mValue))) {}
+
+        Handle(const Handle &o): mValue(o.mValue), mControl(o.shared()) {}
+        Handle &operator=(const Handle &o) {
+            const auto word = o.shared();
+            mValue = o.mValue;
+            mControl.store(word, std::memory_order_relaxed);
+            return *this;
+        }
+        Handle(Handle &&o) noexcept: mValue(o.mValue), mControl(o.mControl.exchange(0, std::memory_order_relaxed)) {}
         Handle &operator=(Handle &&o) noexcept {
-            if (&o != this) mValue = o.mValue, mControl = std::exchange(o.mControl, nullptr);
+            if (&o != this) {
+                mValue = o.mValue;
+                mControl.store(o.mControl.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+            }
             return *this;
         }
         ~Handle() = default;
@@ -84,17 +289,45 @@ namespace kls {
         T &value() noexcept { return mValue; }
         const T &value() const noexcept { return mValue; }
     private:
+        static constexpr uintptr_t inline_tag = 1;
+        using Inline = typename Control::Inline;
+
         T mValue;
-        detail::HandleControl *mControl;
-        void release() noexcept { mControl->release(this); }
-        void acquire() const noexcept { mControl->acquire(); }
+        // either a HandleControl pointer, or an Inline pointer tagged with inline_tag
+        mutable std::atomic<uintptr_t> mControl{};
+
+        static uintptr_t to_word(Control *control) noexcept { return reinterpret_cast<uintptr_t>(control); }
+
+        void release() noexcept {
+            const auto word = mControl.load(std::memory_order_relaxed);
+            if (word & inline_tag) return reinterpret_cast<const Inline *>(word ^ inline_tag)->destruct(this);
+            reinterpret_cast<Control *>(word)->release(&mValue);
+        }
+
+        // a copy shares the reference of its source, so the control block has to exist before the word is copied
+        // or the source and the copy would each run the destructor inline
+        uintptr_t shared() const {
+            auto word = mControl.load(std::memory_order_acquire);
+            if (!(word & inline_tag)) return word;
+            const auto desc = reinterpret_cast<const Inline *>(word ^ inline_tag);
+            const auto control = desc->promote(&mValue);
+            if (mControl.compare_exchange_strong(word, to_word(control), std::memory_order_acq_rel))
+                return to_word(control);
+            // lost against a concurrent promotion, word now holds the winner's control block
+            desc->discard(control);
+            return word;
+        }
+
+        void acquire() const { reinterpret_cast<Control *>(shared())->acquire(); }
     };
 
     struct HandleAccess {
         template<class U>
-        static U duplicate(U &h) noexcept { return h.acquire(), U{h}; }
-        template<class T>
-        static void close(Handle<T> &h) noexcept { if (h.mControl) h.release(); }
+        static U duplicate(U &h) { return h.acquire(), U{h}; }
+        template<class T, class Counting>
+        static void close(Handle<T, Counting> &h) noexcept {
+            if (h.mControl.load(std::memory_order_relaxed)) h.release();
+        }
     };
 
     template<class H>
@@ -103,11 +336,12 @@ namespace kls {
         explicit SafeHandle(H&& h) noexcept: mHandle(std::move(h)) {}
         SafeHandle(SafeHandle &&) noexcept = default;
         SafeHandle &operator=(SafeHandle &&) noexcept = default;
-        SafeHandle(const SafeHandle &o) noexcept: mHandle(HandleAccess::duplicate(o.mHandle)) {}
-        SafeHandle &operator=(const SafeHandle &o) noexcept {
+        SafeHandle(const SafeHandle &o): mHandle(HandleAccess::duplicate(o.mHandle)) {}
+        SafeHandle &operator=(const SafeHandle &o) {
             if (&o != this) {
+                auto duplicate = HandleAccess::duplicate(o.mHandle);
                 HandleAccess::close(mHandle);
-                mHandle = HandleAccess::duplicate(o.mHandle);
+                mHandle = std::move(duplicate);
             }
             return *this;
         }
@@ -121,29 +355,98 @@ namespace kls {
         H mHandle;
     };
 
+    // a moved-from handle is left without a control block and closing it does nothing, so handles relocate bitwise
+    template<class T, class Counting>
+    struct is_trivially_relocatable<Handle<T, Counting>> : std::true_type {};
+
+    template<class H>
+    struct is_trivially_relocatable<SafeHandle<H>> : is_trivially_relocatable<H> {};
+
     namespace detail {
+        template<class Fn>
+        inline constexpr bool is_retired = false;
+
+        template<class Fn>
+        inline constexpr bool is_retired<RetiredDestructor<Fn>> = true;
+
+        // keeps a copy of the value so that the last reference can be dropped away from any handle, the destructor
+        // gets the closing handle's value whenever there is one
+        template<class T, class FnConcrete, class Counting>
+        struct HandleControlBlock : HandleControl<Counting> {
+            pmr::MemoryResource *resource;
+            T value;
+            [[no_unique_address]] FnConcrete callable;
+
+            template<class Fn>
+            HandleControlBlock(pmr::MemoryResource *resource, Fn &&fn, const T &value, int count):
+                    HandleControl<Counting>(&HandleControlBlock::destruct, count), resource(resource), value(value),
+                    callable(std::forward<Fn>(fn)) {}
+
+            static void destruct(HandleControl<Counting> *control, const void *value) noexcept {
+                const auto obj = static_cast<HandleControlBlock *>(control);
+                if (value) obj->value = *static_cast<const T *>(value);
+                if constexpr (is_retired<FnConcrete>) {
+                    try {
+                        return obj->callable.domain->retire(obj, &reclaim);
+                    }
+                    catch (...) {
+                        // no handle refers to the block anymore, closing inline is still correct
+                    }
+                }
+                reclaim(obj);
+            }
+
+            static void reclaim(void *block) noexcept {
+                const auto obj = static_cast<HandleControlBlock *>(block);
+                obj->callable(obj->value);
+                discard(obj);
+            }
+
+            static void discard(HandleControl<Counting> *control) noexcept {
+                const auto obj = static_cast<HandleControlBlock *>(control);
+                const auto resource = obj->resource;
+                std::destroy_at(obj);
+                resource->deallocate(obj, sizeof(HandleControlBlock), alignof(HandleControlBlock));
+            }
+        };
+
+        template<class Counting>
         template<class T, class Fn>
         requires requires(T &h, Fn fn) {
             { fn(h) };
             noexcept(fn(h));
         }
-        inline HandleControl *HandleControl::make(Fn &&destruct) {
+        inline HandleControl<Counting> *HandleControl<Counting>::make(
+                pmr::MemoryResource *resource, Fn &&destruct, const T &value, int count
+        ) {
+            using Block = HandleControlBlock<T, std::decay_t<Fn>, Counting>;
+            const auto memory = resource->allocate(sizeof(Block), alignof(Block));
+            try {
+                return std::construct_at(
+                        static_cast<Block *>(memory), resource, std::forward<Fn>(destruct), value, count
+                );
+            }
+            catch (...) {
+                resource->deallocate(memory, sizeof(Block), alignof(Block));
+                throw;
+            }
+        }
+
+        template<class Counting>
+        template<class T, class Fn>
+        requires StatelessHandleDestructor<Fn>
+        inline auto HandleControl<Counting>::make_inline() noexcept -> const Inline * {
             using FnConcrete = std::decay_t<Fn>;
-            struct Base {
-                FnConcrete callable;
-                HandleControl control;
-            };
-            Base *const base = new Base{
-                    .callable = FnConcrete(std::forward<Fn>(destruct)),
-                    .control = HandleControl{}
-            };
-            base->control.mBasePointer = base;
-            base->control.mBaseDestruct = [](void *base, void *data) noexcept {
-                const auto obj = static_cast<Base *>(base);
-                obj->callable(static_cast<Handle<T> *>(data)->value());
-                delete obj;
+            static constexpr Inline desc{
+                    .destruct = [](void *data) noexcept {
+                        FnConcrete{}(static_cast<Handle<T, Counting> *>(data)->value());
+                    },
+                    .promote = [](const void *value) -> HandleControl * {
+                        return make(pmr::pool_resource(), FnConcrete{}, *static_cast<const T *>(value));
+                    },
+                    .discard = &HandleControlBlock<T, FnConcrete, Counting>::discard
             };
-            return &base->control;
+            return &desc;
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,86 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include "kls/Span.h"
+
+namespace kls::hash {
+    /// <summary>
+    /// CRC-32C (Castagnoli) of the bytes, continuing from the checksum of the preceding bytes
+    /// crc32c(b, crc32c(a)) equals the checksum of a followed by b
+    /// Uses the SSE4.2 crc32 instruction when available and not disabled with simd::set_level(Level::Scalar)
+    /// </summary>
+    uint32_t crc32c(Span<> data, uint32_t crc = 0) noexcept;
+
+    /// <summary>
+    /// Whether crc32c currently runs on the crc32 instruction
+    /// </summary>
+    bool crc32c_accelerated() noexcept;
+
+    /// <summary>
+    /// Incremental CRC-32C
+    /// </summary>
+    class Crc32c {
+    public:
+        void update(Span<> data) noexcept { mValue = crc32c(data, mValue); }
+
+        [[nodiscard]] uint32_t value() const noexcept { return mValue; }
+
+        void reset() noexcept { mValue = 0; }
+    private:
+        uint32_t mValue{0};
+    };
+
+    /// <summary>
+    /// Fast non-cryptographic 64 bit hash: inputs of up to 128 bytes are mixed with 128 bit multiplies, longer
+    /// inputs run through eight 64 bit accumulators in 64 byte stripes that vectorize
+    /// The result is the same on every platform, it is not compatible with any other hash function
+    /// </summary>
+    uint64_t hash64(Span<> data, uint64_t seed = 0) noexcept;
+
+    /// <summary>
+    /// Incremental hash64, the digest equals hash64 of all bytes passed to update, however they are split
+    /// </summary>
+    class Hasher64 {
+    public:
+        explicit Hasher64(uint64_t seed = 0) noexcept { reset(seed); }
+
+        void update(Span<> data) noexcept;
+
+        [[nodiscard]] uint64_t digest() const noexcept;
+
+        void reset(uint64_t seed = 0) noexcept;
+
+        static constexpr size_t stripe = 64;
+        static constexpr size_t buffer = 4 * stripe;
+    private:
+        uint64_t mAcc[8];
+        uint64_t mSeed;
+        uint64_t mTotal;
+        size_t mStripes;
+        size_t mBuffered;
+        alignas(stripe) unsigned char mBuffer[buffer];
+        unsigned char mLast[stripe];
+    };
+}
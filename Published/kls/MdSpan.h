@@ -0,0 +1,439 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <concepts>
+#include <type_traits>
+#include "kls/Span.h"
+
+namespace kls {
+    /// <summary>
+    /// The extents of a multidimensional span, each either fixed at compile time or dynamic_extent
+    /// Only the dynamic extents are stored
+    /// </summary>
+    template<size_t... Es>
+    class Extents {
+        static_assert(sizeof...(Es) > 0, "Extents needs at least one dimension");
+        static constexpr size_t sStatic[] = {Es...};
+        static constexpr size_t sRankDynamic = ((Es == dynamic_extent ? 1 : 0) + ...);
+    public:
+        using Index = std::array<size_t, sizeof...(Es)>;
+
+        static constexpr size_t rank() noexcept { return sizeof...(Es); }
+
+        static constexpr size_t rank_dynamic() noexcept { return sRankDynamic; }
+
+        static constexpr size_t static_extent(size_t r) noexcept { return sStatic[r]; }
+
+        constexpr Extents() noexcept = default;
+
+        /// <summary>
+        /// Creates extents from the values of the dynamic extents, in order
+        /// </summary>
+        template<std::integral... Is>
+        requires (sizeof...(Is) == sRankDynamic && sRankDynamic > 0)
+        constexpr explicit Extents(Is... dynamic) noexcept: mDynamic{size_t(dynamic)...} {}
+
+        /// <summary>
+        /// Creates extents from the values of all extents, the static ones are ignored
+        /// </summary>
+        constexpr explicit Extents(const Index &all) noexcept {
+            if constexpr (sRankDynamic > 0) {
+                for (size_t r = 0; r < rank(); ++r) if (sStatic[r] == dynamic_extent) mDynamic[dynamic_index(r)] = all[r];
+            }
+        }
+
+        [[nodiscard]] constexpr size_t extent(size_t r) const noexcept {
+            if constexpr (sRankDynamic > 0) if (sStatic[r] == dynamic_extent) return mDynamic[dynamic_index(r)];
+            return sStatic[r];
+        }
+
+        [[nodiscard]] constexpr size_t size() const noexcept {
+            size_t result = 1;
+            for (size_t r = 0; r < rank(); ++r) result *= extent(r);
+            return result;
+        }
+    private:
+        struct Static {};
+
+        // std::array<size_t, 0> is not an empty class, fully static extents should take no space
+        [[no_unique_address]] std::conditional_t<sRankDynamic == 0, Static, std::array<size_t, sRankDynamic>> mDynamic{};
+
+        static constexpr size_t dynamic_index(size_t r) noexcept {
+            size_t result = 0;
+            for (size_t i = 0; i < r; ++i) result += sStatic[i] == dynamic_extent;
+            return result;
+        }
+    };
+
+    namespace detail {
+        template<size_t... Is>
+        Extents<(Is, dynamic_extent)...> dynamic_extents(std::index_sequence<Is...>);
+
+        // visits the indices with the last one moving fastest, tracking the offset through the strides
+        template<class E, class Strides, class Fn>
+        constexpr void visit_strided(const E &extents, const Strides &strides, Fn &&fn) {
+            if (!extents.size()) return;
+            typename E::Index idx{};
+            size_t offset = 0;
+            for (size_t n = extents.size(); n; --n) {
+                fn(idx, offset);
+                for (size_t r = E::rank(); r-- > 0;) {
+                    offset += strides[r];
+                    if (++idx[r] < extents.extent(r)) break;
+                    offset -= strides[r] * idx[r];
+                    idx[r] = 0;
+                }
+            }
+        }
+    }
+
+    template<size_t R>
+    using DynamicExtents = decltype(detail::dynamic_extents(std::make_index_sequence<R>{}));
+
+    /// <summary>
+    /// Row-major layout, the last index is contiguous
+    /// </summary>
+    struct LayoutRight {
+        template<class E>
+        class Mapping {
+        public:
+            static constexpr bool always_contiguous = true;
+
+            constexpr Mapping() noexcept = default;
+
+            constexpr explicit Mapping(const E &extents) noexcept: mExtents(extents) {}
+
+            [[nodiscard]] constexpr const E &extents() const noexcept { return mExtents; }
+
+            constexpr size_t operator()(const typename E::Index &idx) const noexcept {
+                size_t offset = 0;
+                for (size_t r = 0; r < E::rank(); ++r) offset = offset * mExtents.extent(r) + idx[r];
+                return offset;
+            }
+
+            [[nodiscard]] constexpr size_t stride(size_t r) const noexcept {
+                size_t result = 1;
+                for (size_t i = r + 1; i < E::rank(); ++i) result *= mExtents.extent(i);
+                return result;
+            }
+
+            [[nodiscard]] constexpr size_t required_size() const noexcept { return mExtents.size(); }
+
+            template<class Fn>
+            constexpr void visit(Fn &&fn) const {
+                typename E::Index idx{};
+                for (size_t offset = 0, size = mExtents.size(); offset < size; ++offset) {
+                    fn(idx, offset);
+                    for (size_t r = E::rank(); r-- > 0;) {
+                        if (++idx[r] < mExtents.extent(r)) break;
+                        idx[r] = 0;
+                    }
+                }
+            }
+        private:
+            [[no_unique_address]] E mExtents{};
+        };
+    };
+
+    /// <summary>
+    /// Column-major layout, the first index is contiguous
+    /// </summary>
+    struct LayoutLeft {
+        template<class E>
+        class Mapping {
+        public:
+            static constexpr bool always_contiguous = true;
+
+            constexpr Mapping() noexcept = default;
+
+            constexpr explicit Mapping(const E &extents) noexcept: mExtents(extents) {}
+
+            [[nodiscard]] constexpr const E &extents() const noexcept { return mExtents; }
+
+            constexpr size_t operator()(const typename E::Index &idx) const noexcept {
+                size_t offset = 0;
+                for (size_t r = E::rank(); r-- > 0;) offset = offset * mExtents.extent(r) + idx[r];
+                return offset;
+            }
+
+            [[nodiscard]] constexpr size_t stride(size_t r) const noexcept {
+                size_t result = 1;
+                for (size_t i = 0; i < r; ++i) result *= mExtents.extent(i);
+                return result;
+            }
+
+            [[nodiscard]] constexpr size_t required_size() const noexcept { return mExtents.size(); }
+
+            template<class Fn>
+            constexpr void visit(Fn &&fn) const {
+                typename E::Index idx{};
+                for (size_t offset = 0, size = mExtents.size(); offset < size; ++offset) {
+                    fn(idx, offset);
+                    for (size_t r = 0; r < E::rank(); ++r) {
+                        if (++idx[r] < mExtents.extent(r)) break;
+                        idx[r] = 0;
+                    }
+                }
+            }
+        private:
+            [[no_unique_address]] E mExtents{};
+        };
+    };
+
+    /// <summary>
+    /// Layout with an arbitrary stride per dimension, used for views into other layouts
+    /// </summary>
+    struct LayoutStride {
+        template<class E>
+        class Mapping {
+        public:
+            static constexpr bool always_contiguous = false;
+
+            constexpr Mapping() noexcept = default;
+
+            constexpr Mapping(const E &extents, const typename E::Index &strides) noexcept:
+                    mExtents(extents), mStrides(strides) {}
+
+            [[nodiscard]] constexpr const E &extents() const noexcept { return mExtents; }
+
+            constexpr size_t operator()(const typename E::Index &idx) const noexcept {
+                size_t offset = 0;
+                for (size_t r = 0; r < E::rank(); ++r) offset += idx[r] * mStrides[r];
+                return offset;
+            }
+
+            [[nodiscard]] constexpr size_t stride(size_t r) const noexcept { return mStrides[r]; }
+
+            [[nodiscard]] constexpr size_t required_size() const noexcept {
+                if (!mExtents.size()) return 0;
+                size_t result = 1;
+                for (size_t r = 0; r < E::rank(); ++r) result += (mExtents.extent(r) - 1) * mStrides[r];
+                return result;
+            }
+
+            template<class Fn>
+            constexpr void visit(Fn &&fn) const { detail::visit_strided(mExtents, mStrides, std::forward<Fn>(fn)); }
+        private:
+            [[no_unique_address]] E mExtents{};
+            typename E::Index mStrides{};
+        };
+    };
+
+    /// <summary>
+    /// Z-order layout, the bits of the indices are interleaved so that nearby cells in every dimension stay close
+    /// in memory. Storage is exhaustive when all extents are the same power of two
+    /// </summary>
+    struct LayoutMorton {
+        template<class E>
+        class Mapping {
+        public:
+            static constexpr bool always_contiguous = false;
+
+            constexpr Mapping() noexcept = default;
+
+            constexpr explicit Mapping(const E &extents) noexcept: mExtents(extents) {}
+
+            [[nodiscard]] constexpr const E &extents() const noexcept { return mExtents; }
+
+            constexpr size_t operator()(const typename E::Index &idx) const noexcept {
+                if constexpr (E::rank() == 1) return idx[0];
+                else if constexpr (E::rank() == 2) return spread2(idx[0]) << 1 | spread2(idx[1]);
+                else if constexpr (E::rank() == 3) return spread3(idx[0]) << 2 | spread3(idx[1]) << 1 | spread3(idx[2]);
+                else {
+                    size_t offset = 0;
+                    for (size_t bit = 0; bit * E::rank() < 64; ++bit) {
+                        for (size_t r = 0; r < E::rank(); ++r) {
+                            const auto at = bit * E::rank() + E::rank() - 1 - r;
+                            if (at < 64) offset |= ((idx[r] >> bit) & 1) << at;
+                        }
+                    }
+                    return offset;
+                }
+            }
+
+            [[nodiscard]] constexpr size_t required_size() const noexcept {
+                if (!mExtents.size()) return 0;
+                typename E::Index last{};
+                for (size_t r = 0; r < E::rank(); ++r) last[r] = mExtents.extent(r) - 1;
+                return (*this)(last) + 1;
+            }
+
+            // walks the storage in order, one aligned block of the curve at a time, blocks that lie entirely outside of
+            // the extents are skipped as a whole
+            template<class Fn>
+            constexpr void visit(Fn &&fn) const {
+                if (!mExtents.size()) return;
+                size_t widest = 1, levels = 0;
+                for (size_t r = 0; r < E::rank(); ++r) if (mExtents.extent(r) > widest) widest = mExtents.extent(r);
+                while ((size_t(1) << levels) < widest) ++levels;
+                typename E::Index origin{}, limit{};
+                for (size_t r = 0; r < E::rank(); ++r) limit[r] = mExtents.extent(r);
+                if (levels == 0) return fn(std::as_const(origin), size_t(0));
+                visit_block(fn, origin, limit, 0, levels);
+            }
+        private:
+            [[no_unique_address]] E mExtents{};
+
+            // origin is the lowest corner of a block of 2^level per axis starting at offset, each child block takes one
+            // bit per axis from the top of the remaining code, axis 0 taking the highest like in operator()
+            template<class Fn>
+            static constexpr void visit_block(
+                    Fn &fn, const typename E::Index &origin, const typename E::Index &limit, size_t offset, size_t level
+            ) {
+                const auto half = size_t(1) << (level - 1);
+                const auto shift = E::rank() * (level - 1);
+                for (size_t child = 0; child < (size_t(1) << E::rank()); ++child) {
+                    auto corner = origin;
+                    bool inside = true;
+                    for (size_t r = 0; r < E::rank(); ++r) {
+                        corner[r] |= ((child >> (E::rank() - 1 - r)) & 1) * half;
+                        inside = inside && corner[r] < limit[r];
+                    }
+                    if (!inside) continue;
+                    if (level == 1) fn(std::as_const(corner), offset | child);
+                    else visit_block(fn, corner, limit, offset | child << shift, level - 1);
+                }
+            }
+
+            static constexpr size_t spread2(size_t x) noexcept {
+                x &= 0xFFFFFFFF;
+                x = (x | x << 16) & 0x0000FFFF0000FFFF;
+                x = (x | x << 8) & 0x00FF00FF00FF00FF;
+                x = (x | x << 4) & 0x0F0F0F0F0F0F0F0F;
+                x = (x | x << 2) & 0x3333333333333333;
+                return (x | x << 1) & 0x5555555555555555;
+            }
+
+            static constexpr size_t spread3(size_t x) noexcept {
+                x &= 0x1FFFFF;
+                x = (x | x << 32) & 0x1F00000000FFFF;
+                x = (x | x << 16) & 0x1F0000FF0000FF;
+                x = (x | x << 8) & 0x100F00F00F00F00F;
+                x = (x | x << 4) & 0x10C30C30C30C30C3;
+                return (x | x << 2) & 0x1249249249249249;
+            }
+        };
+    };
+
+    /// <summary>
+    /// Non-owning multidimensional view over a contiguous block, the layout maps indices to offsets in the block
+    /// </summary>
+    /// <typeparam name="T"> The element type </typeparam>
+    /// <typeparam name="E"> The Extents of the view </typeparam>
+    /// <typeparam name="Layout"> The layout policy </typeparam>
+    template<class T, class E, class Layout = LayoutRight>
+    class BasicMdSpan {
+    public:
+        using extents_type = E;
+        using layout_type = Layout;
+        using mapping_type = typename Layout::template Mapping<E>;
+        using Index = typename E::Index;
+
+        constexpr BasicMdSpan(T *data, const mapping_type &mapping) noexcept: mData(data), mMapping(mapping) {}
+
+        constexpr explicit BasicMdSpan(T *data) noexcept requires (E::rank_dynamic() == 0):
+                mData(data), mMapping(E{}) {}
+
+        template<std::integral... Is>
+        requires (sizeof...(Is) == E::rank_dynamic() && sizeof...(Is) > 0)
+        constexpr BasicMdSpan(T *data, Is... dynamic) noexcept: mData(data), mMapping(E(dynamic...)) {}
+
+        static constexpr size_t rank() noexcept { return E::rank(); }
+
+        [[nodiscard]] constexpr size_t extent(size_t r) const noexcept { return mMapping.extents().extent(r); }
+
+        [[nodiscard]] constexpr const E &extents() const noexcept { return mMapping.extents(); }
+
+        [[nodiscard]] constexpr size_t size() const noexcept { return mMapping.extents().size(); }
+
+        [[nodiscard]] constexpr const mapping_type &mapping() const noexcept { return mMapping; }
+
+        constexpr T *data() const noexcept { return mData; }
+
+        template<std::integral... Is>
+        requires (sizeof...(Is) == E::rank())
+        constexpr T &operator()(Is... idx) const noexcept { return mData[mMapping(Index{size_t(idx)...})]; }
+
+        constexpr T &operator[](const Index &idx) const noexcept { return mData[mMapping(idx)]; }
+
+        /// <summary>
+        /// The layout maps the indices onto exactly the first size() elements of the block
+        /// </summary>
+        [[nodiscard]] constexpr bool is_contiguous() const noexcept { return mMapping.required_size() == size(); }
+
+        /// <summary>
+        /// The block in storage order, only holds exactly the elements of the view if is_contiguous()
+        /// </summary>
+        constexpr Span<T> span() const noexcept { return Span<T>(mData, mMapping.required_size()); }
+
+        constexpr operator Span<T>() const noexcept requires mapping_type::always_contiguous { return span(); } // NOLINT
+
+        /// <summary>
+        /// Calls fn(element, index) for every element, in the order of the storage
+        /// </summary>
+        template<class Fn>
+        constexpr void for_each(Fn &&fn) const {
+            mMapping.visit([this, &fn](const Index &idx, size_t offset) { fn(mData[offset], idx); });
+        }
+
+        /// <summary>
+        /// A view of the box starting at offset with the given extents
+        /// </summary>
+        constexpr auto tile(const Index &offset, const Index &extents) const noexcept
+        requires requires(const mapping_type &m) { m.stride(0); } {
+            using Tile = DynamicExtents<E::rank()>;
+            Index strides{};
+            for (size_t r = 0; r < E::rank(); ++r) strides[r] = mMapping.stride(r);
+            return BasicMdSpan<T, Tile, LayoutStride>(
+                    mData + mMapping(offset), typename LayoutStride::template Mapping<Tile>(Tile(extents), strides)
+            );
+        }
+
+        /// <summary>
+        /// A view of one layer, with the first index fixed
+        /// </summary>
+        constexpr auto slice(size_t index) const noexcept
+        requires (E::rank() > 1) && requires(const mapping_type &m) { m.stride(0); } {
+            using Layer = DynamicExtents<E::rank() - 1>;
+            typename Layer::Index extents{}, strides{};
+            for (size_t r = 1; r < E::rank(); ++r) {
+                extents[r - 1] = extent(r);
+                strides[r - 1] = mMapping.stride(r);
+            }
+            return BasicMdSpan<T, Layer, LayoutStride>(
+                    mData + index * mMapping.stride(0),
+                    typename LayoutStride::template Mapping<Layer>(Layer(extents), strides)
+            );
+        }
+    private:
+        T *mData;
+        [[no_unique_address]] mapping_type mMapping;
+    };
+
+    template<class T, size_t... Es>
+    using MdSpan = BasicMdSpan<T, Extents<Es...>>;
+}
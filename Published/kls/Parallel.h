@@ -0,0 +1,150 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include "kls/Span.h"
+#include "kls/temp/Temp.h"
+
+namespace kls::parallel {
+    /// <summary>
+    /// The number of threads, including the caller, that work on one call of the algorithms below
+    /// </summary>
+    size_t concurrency() noexcept;
+
+    /// <summary>
+    /// Sets the number of threads that work on one call, starting pool threads if needed
+    /// The default is the number of hardware threads, 1 makes every algorithm run serially on the caller
+    /// </summary>
+    /// <returns> The concurrency actually selected </returns>
+    size_t set_concurrency(size_t threads);
+
+    /// <summary>
+    /// Spans are split into chunks of about this many bytes, small enough to stay in a private cache
+    /// </summary>
+    inline constexpr size_t chunk_bytes = size_t(256) << 10;
+
+    /// <summary>
+    /// Spans smaller than this many bytes are processed serially on the calling thread
+    /// </summary>
+    inline constexpr size_t serial_bytes = size_t(1) << 20;
+
+    namespace detail {
+        /// <summary>
+        /// Calls fn(context, chunk) once for every chunk in [0, chunks) on the pool and the calling thread
+        /// Runs serially on the caller when it is a pool thread, calls from several threads share the pool
+        /// The first exception thrown by fn is rethrown once all chunks are done
+        /// </summary>
+        void run(size_t chunks, void (*fn)(void *context, size_t chunk), void *context);
+
+        template<class Fn>
+        void run(size_t chunks, Fn &&fn) {
+            if (chunks == 1) return fn(size_t(0));
+            run(chunks, [](void *context, size_t chunk) {
+                (*static_cast<std::remove_reference_t<Fn> *>(context))(chunk);
+            }, const_cast<void *>(static_cast<const void *>(std::addressof(fn))));
+        }
+
+        template<class T>
+        inline constexpr size_t chunk_items = std::max<size_t>(1, chunk_bytes / sizeof(T));
+
+        template<class T>
+        size_t chunks(size_t size) noexcept {
+            if (size * sizeof(T) < serial_bytes || concurrency() == 1) return 1;
+            return (size + chunk_items<T> - 1) / chunk_items<T>;
+        }
+
+        template<class T>
+        Span<T> chunk(Span<T> span, size_t chunks, size_t index) noexcept {
+            if (chunks == 1) return span;
+            return span.trim_front(index * chunk_items<T>).keep_front(chunk_items<T>);
+        }
+    }
+
+    /// <summary>
+    /// Parallel kls::copy, returns false without copying if the spans have different sizes
+    /// </summary>
+    template<class T>
+    bool copy(Span<T> src, Span<T> dst) {
+        if (src.size() != dst.size()) return false;
+        const auto chunks = detail::chunks<T>(src.size());
+        detail::run(chunks, [&](size_t i) {
+            kls::copy(detail::chunk(src, chunks, i), detail::chunk(dst, chunks, i));
+        });
+        return true;
+    }
+
+    /// <summary>
+    /// Stores fn(src[i]) into dst[i], returns false without calling fn if the spans have different sizes
+    /// fn is called concurrently and in no particular order
+    /// </summary>
+    template<class T, class U, class Fn>
+    bool transform(Span<T> src, Span<U> dst, Fn &&fn) {
+        if (src.size() != dst.size()) return false;
+        const auto chunks = detail::chunks<T>(src.size());
+        detail::run(chunks, [&](size_t i) {
+            auto in = detail::chunk(src, chunks, i);
+            auto out = detail::chunk(dst, chunks, i);
+            for (size_t j = 0; j < in.size(); ++j) out.data()[j] = fn(in.data()[j]);
+        });
+        return true;
+    }
+
+    /// <summary>
+    /// Calls fn(item) for every item, concurrently and in no particular order
+    /// </summary>
+    template<class T, class Fn>
+    void for_each(Span<T> span, Fn &&fn) {
+        const auto chunks = detail::chunks<T>(span.size());
+        detail::run(chunks, [&](size_t i) { for (auto &&item: detail::chunk(span, chunks, i)) fn(item); });
+    }
+
+    /// <summary>
+    /// Folds the span into init with op, which must be associative
+    /// Every chunk is folded separately starting from its first item, the partial results are then folded into init
+    /// in order, so op is called with (R, T) and (R, R)
+    /// </summary>
+    template<class T, class R, class Op>
+    R reduce(Span<T> span, R init, Op &&op) {
+        const auto chunks = detail::chunks<T>(span.size());
+        const auto fold = [&](Span<T> part) {
+            R result(part.data()[0]);
+            for (size_t j = 1; j < part.size(); ++j) result = op(std::move(result), part.data()[j]);
+            return result;
+        };
+        if (chunks == 1) {
+            for (auto &&item: span) init = op(std::move(init), item);
+            return init;
+        }
+        // the partial results are scratch of this call only, the temp allocator hands them out cheaply
+        const auto partials = temp::make_unique<std::optional<R>[]>(chunks);
+        detail::run(chunks, [&](size_t i) { partials[i].emplace(fold(detail::chunk(span, chunks, i))); });
+        for (size_t i = 0; i < chunks; ++i) init = op(std::move(init), std::move(*partials[i]));
+        return init;
+    }
+}
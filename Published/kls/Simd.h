@@ -0,0 +1,258 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <limits>
+#include <cstdint>
+#include <concepts>
+#include <type_traits>
+#include "kls/Span.h"
+
+namespace kls::simd {
+    /// <summary>
+    /// Instruction set levels the span kernels are built for, Scalar is the portable fallback
+    /// </summary>
+    enum class Level { Scalar, SSE2, AVX2, AVX512 };
+
+    /// <summary>
+    /// The highest level supported by both the build and the processor
+    /// </summary>
+    Level supported_level() noexcept;
+
+    /// <summary>
+    /// The level the kernels currently dispatch to, supported_level() unless lowered by set_level()
+    /// </summary>
+    Level level() noexcept;
+
+    /// <summary>
+    /// Selects the level the kernels dispatch to, clamped to supported_level()
+    /// Mainly useful for checking the kernels of every level against each other
+    /// </summary>
+    /// <returns> The level actually selected </returns>
+    Level set_level(Level level) noexcept;
+
+    template<class T>
+    concept Arithmetic = std::is_arithmetic_v<T> && !std::same_as<T, bool> && !std::same_as<T, long double>;
+
+    namespace detail {
+        template<class T>
+        struct Kernel {
+            using type = std::conditional_t<
+                    std::is_signed_v<T>,
+                    std::conditional_t<sizeof(T) == 1, int8_t, std::conditional_t<sizeof(T) == 2, int16_t,
+                            std::conditional_t<sizeof(T) == 4, int32_t, int64_t>>>,
+                    std::conditional_t<sizeof(T) == 1, uint8_t, std::conditional_t<sizeof(T) == 2, uint16_t,
+                            std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>
+            >;
+        };
+
+        template<std::floating_point T>
+        struct Kernel<T> {
+            using type = T;
+        };
+
+        template<class T>
+        using kernel_t = typename Kernel<T>::type;
+
+        template<class T>
+        using sum_t = std::conditional_t<
+                std::is_floating_point_v<T>, T, std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>
+        >;
+
+        template<class T>
+        struct Kernels {
+            void (*fill)(T *data, size_t size, T value) noexcept;
+            bool (*equal)(const T *a, const T *b, size_t size) noexcept;
+            size_t (*find)(const T *data, size_t size, T value) noexcept;
+            size_t (*find_not)(const T *data, size_t size, T value) noexcept;
+            size_t (*count)(const T *data, size_t size, T value) noexcept;
+            T (*min)(const T *data, size_t size) noexcept;
+            T (*max)(const T *data, size_t size) noexcept;
+            sum_t<T> (*sum)(const T *data, size_t size) noexcept;
+        };
+
+        template<class T>
+        const Kernels<T> &kernels() noexcept;
+
+        extern template const Kernels<int8_t> &kernels() noexcept;
+        extern template const Kernels<uint8_t> &kernels() noexcept;
+        extern template const Kernels<int16_t> &kernels() noexcept;
+        extern template const Kernels<uint16_t> &kernels() noexcept;
+        extern template const Kernels<int32_t> &kernels() noexcept;
+        extern template const Kernels<uint32_t> &kernels() noexcept;
+        extern template const Kernels<int64_t> &kernels() noexcept;
+        extern template const Kernels<uint64_t> &kernels() noexcept;
+        extern template const Kernels<float> &kernels() noexcept;
+        extern template const Kernels<double> &kernels() noexcept;
+
+        template<class T>
+        auto cast(T *data) noexcept {
+            if constexpr (std::is_const_v<T>)
+                return reinterpret_cast<const kernel_t<std::remove_const_t<T>> *>(data);
+            else
+                return reinterpret_cast<kernel_t<T> *>(data);
+        }
+    }
+
+    template<Arithmetic T>
+    void fill(Span<T> span, T value) noexcept {
+        detail::kernels<detail::kernel_t<T>>().fill(detail::cast(span.data()), span.size(), value);
+    }
+
+    /// <summary>
+    /// Element-wise comparison with operator==, spans of different sizes are never equal
+    /// </summary>
+    template<Arithmetic T>
+    bool equal(Span<T> a, Span<T> b) noexcept {
+        if (a.size() != b.size()) return false;
+        return detail::kernels<detail::kernel_t<T>>().equal(detail::cast(a.data()), detail::cast(b.data()), a.size());
+    }
+
+    /// <returns> The index of the first element equal to value, or the size of the span if there is none </returns>
+    template<Arithmetic T>
+    size_t find(Span<T> span, T value) noexcept {
+        return detail::kernels<detail::kernel_t<T>>().find(detail::cast(span.data()), span.size(), value);
+    }
+
+    /// <returns> The index of the first element not equal to value, or the size of the span if there is none </returns>
+    template<Arithmetic T>
+    size_t find_first_not(Span<T> span, T value) noexcept {
+        return detail::kernels<detail::kernel_t<T>>().find_not(detail::cast(span.data()), span.size(), value);
+    }
+
+    /// <returns> The index of the first byte equal to value, or the size of the span if there is none </returns>
+    inline size_t find(Span<> span, uint8_t value) noexcept {
+        return detail::kernels<uint8_t>().find(static_cast<const uint8_t *>(span.data()), span.size(), value);
+    }
+
+    template<Arithmetic T>
+    size_t count(Span<T> span, T value) noexcept {
+        return detail::kernels<detail::kernel_t<T>>().count(detail::cast(span.data()), span.size(), value);
+    }
+
+    /// <summary>
+    /// The smallest element, or the largest representable value for an empty span
+    /// Which element is picked is unspecified if the span contains NaN
+    /// </summary>
+    template<Arithmetic T>
+    T min(Span<T> span) noexcept {
+        if (!span.size()) return std::numeric_limits<T>::max();
+        return T(detail::kernels<detail::kernel_t<T>>().min(detail::cast(span.data()), span.size()));
+    }
+
+    /// <summary>
+    /// The largest element, or the lowest representable value for an empty span
+    /// Which element is picked is unspecified if the span contains NaN
+    /// </summary>
+    template<Arithmetic T>
+    T max(Span<T> span) noexcept {
+        if (!span.size()) return std::numeric_limits<T>::lowest();
+        return T(detail::kernels<detail::kernel_t<T>>().max(detail::cast(span.data()), span.size()));
+    }
+
+    /// <summary>
+    /// Sum of the elements, integers are summed in 64 bits, floating point values in their own type with the
+    /// additions reordered
+    /// </summary>
+    template<Arithmetic T>
+    detail::sum_t<T> sum(Span<T> span) noexcept {
+        return detail::kernels<detail::kernel_t<T>>().sum(detail::cast(span.data()), span.size());
+    }
+
+    namespace detail {
+        // fixed extents up to this size are handled by loops the compiler unrolls, larger ones go through dispatch
+        template<class T, size_t N>
+        inline constexpr bool inline_extent = N * sizeof(T) <= 256;
+    }
+
+    template<Arithmetic T, size_t N>
+    requires (N != dynamic_extent)
+    void fill(Span<T, N> span, T value) noexcept {
+        if constexpr (detail::inline_extent<T, N>) for (auto &x: span) x = value; else fill(Span<T>(span), value);
+    }
+
+    template<Arithmetic T, size_t N>
+    requires (N != dynamic_extent)
+    bool equal(Span<T, N> a, Span<T, N> b) noexcept {
+        if constexpr (!detail::inline_extent<T, N>) return equal(Span<T>(a), Span<T>(b));
+        bool result = true;
+        for (size_t i = 0; i < N; ++i) result &= a.data()[i] == b.data()[i];
+        return result;
+    }
+
+    template<Arithmetic T, size_t N>
+    requires (N != dynamic_extent)
+    size_t find(Span<T, N> span, T value) noexcept {
+        if constexpr (!detail::inline_extent<T, N>) return find(Span<T>(span), value);
+        for (size_t i = 0; i < N; ++i) if (span.data()[i] == value) return i;
+        return N;
+    }
+
+    template<Arithmetic T, size_t N>
+    requires (N != dynamic_extent)
+    size_t find_first_not(Span<T, N> span, T value) noexcept {
+        if constexpr (!detail::inline_extent<T, N>) return find_first_not(Span<T>(span), value);
+        for (size_t i = 0; i < N; ++i) if (span.data()[i] != value) return i;
+        return N;
+    }
+
+    template<Arithmetic T, size_t N>
+    requires (N != dynamic_extent)
+    size_t count(Span<T, N> span, T value) noexcept {
+        if constexpr (!detail::inline_extent<T, N>) return count(Span<T>(span), value);
+        size_t result = 0;
+        for (auto x: span) result += x == value;
+        return result;
+    }
+
+    template<Arithmetic T, size_t N>
+    requires (N != dynamic_extent)
+    T min(Span<T, N> span) noexcept {
+        if constexpr (!detail::inline_extent<T, N> || N == 0) return min(Span<T>(span));
+        else {
+            auto result = span.data()[0];
+            for (auto x: span) result = x < result ? x : result;
+            return result;
+        }
+    }
+
+    template<Arithmetic T, size_t N>
+    requires (N != dynamic_extent)
+    T max(Span<T, N> span) noexcept {
+        if constexpr (!detail::inline_extent<T, N> || N == 0) return max(Span<T>(span));
+        else {
+            auto result = span.data()[0];
+            for (auto x: span) result = x > result ? x : result;
+            return result;
+        }
+    }
+
+    template<Arithmetic T, size_t N>
+    requires (N != dynamic_extent)
+    detail::sum_t<T> sum(Span<T, N> span) noexcept {
+        if constexpr (!detail::inline_extent<T, N>) return sum(Span<T>(span));
+        detail::sum_t<T> result{};
+        for (auto x: span) result += x;
+        return result;
+    }
+}
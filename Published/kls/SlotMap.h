@@ -0,0 +1,174 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+#include "kls/Span.h"
+#include "kls/pmr/Allocator.h"
+
+namespace kls {
+    /// <summary>
+    /// Key to an entry of a SlotMap, the generation tells apart entries that reused the same slot
+    /// </summary>
+    struct SlotKey {
+        uint32_t index = std::numeric_limits<uint32_t>::max();
+        uint32_t generation = 0;
+
+        friend constexpr bool operator==(SlotKey, SlotKey) noexcept = default;
+    };
+
+    /// <summary>
+    /// Table of values addressed by generational keys
+    /// Values are kept densely packed in insertion order until erased, erase moves the last value into the hole.
+    /// Keys of erased entries are detected as stale until their slot has been reused 2^32 times
+    /// </summary>
+    /// <typeparam name="T"> The type of the stored values </typeparam>
+    template<class T>
+    class SlotMap {
+        struct Slot {
+            // dense position while occupied, next free slot otherwise
+            uint32_t target;
+            uint32_t generation;
+        };
+        static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+        template<class U>
+        using Vector = std::vector<U, pmr::PolymorphicAllocator<U>>;
+    public:
+        explicit SlotMap(pmr::PolymorphicAllocator<T> alloc = {}):
+                mSlots(alloc), mValues(alloc), mOwners(alloc) {}
+
+        template<class... Ts>
+        SlotKey emplace(Ts &&... args) {
+            const auto index = acquire();
+            try {
+                mOwners.push_back(index);
+                mValues.emplace_back(std::forward<Ts>(args)...);
+            }
+            catch (...) {
+                if (mOwners.size() > mValues.size()) mOwners.pop_back();
+                auto &slot = mSlots[index];
+                slot.target = std::exchange(mFree, index);
+                ++slot.generation;
+                throw;
+            }
+            auto &slot = mSlots[index];
+            slot.target = uint32_t(mValues.size() - 1);
+            return SlotKey{index, slot.generation};
+        }
+
+        SlotKey insert(const T &value) { return emplace(value); }
+
+        SlotKey insert(T &&value) { return emplace(std::move(value)); }
+
+        bool erase(SlotKey key) {
+            if (!contains(key)) return false;
+            auto &slot = mSlots[key.index];
+            const auto position = slot.target;
+            if (const auto last = uint32_t(mValues.size() - 1); position != last) {
+                mValues[position] = std::move(mValues[last]);
+                mOwners[position] = mOwners[last];
+                mSlots[mOwners[position]].target = position;
+            }
+            mValues.pop_back();
+            mOwners.pop_back();
+            slot.target = std::exchange(mFree, key.index);
+            ++slot.generation;
+            return true;
+        }
+
+        [[nodiscard]] bool contains(SlotKey key) const noexcept {
+            return key.index < mSlots.size() && mSlots[key.index].generation == key.generation;
+        }
+
+        [[nodiscard]] T *find(SlotKey key) noexcept { return contains(key) ? &mValues[mSlots[key.index].target] : nullptr; }
+
+        [[nodiscard]] const T *find(SlotKey key) const noexcept {
+            return contains(key) ? &mValues[mSlots[key.index].target] : nullptr;
+        }
+
+        /// <summary>
+        /// Unchecked access, the key must be valid
+        /// </summary>
+        T &operator[](SlotKey key) noexcept { return mValues[mSlots[key.index].target]; }
+
+        const T &operator[](SlotKey key) const noexcept { return mValues[mSlots[key.index].target]; }
+
+        /// <summary>
+        /// Key of the value at the given dense position
+        /// </summary>
+        [[nodiscard]] SlotKey key_at(size_t position) const noexcept {
+            const auto index = mOwners[position];
+            return SlotKey{index, mSlots[index].generation};
+        }
+
+        [[nodiscard]] Span<T> values() noexcept { return Span<T>(mValues.data(), mValues.size()); }
+
+        [[nodiscard]] Span<T> values() const noexcept { return Span<T>(mValues.data(), mValues.size()); }
+
+        T *begin() noexcept { return mValues.data(); }
+
+        T *end() noexcept { return mValues.data() + mValues.size(); }
+
+        const T *begin() const noexcept { return mValues.data(); }
+
+        const T *end() const noexcept { return mValues.data() + mValues.size(); }
+
+        [[nodiscard]] size_t size() const noexcept { return mValues.size(); }
+
+        [[nodiscard]] bool empty() const noexcept { return mValues.empty(); }
+
+        void reserve(size_t count) {
+            mSlots.reserve(count);
+            mValues.reserve(count);
+            mOwners.reserve(count);
+        }
+
+        /// <summary>
+        /// Removes all values, keys handed out before stay stale
+        /// </summary>
+        void clear() noexcept {
+            for (const auto index: mOwners) {
+                mSlots[index].target = std::exchange(mFree, index);
+                ++mSlots[index].generation;
+            }
+            mValues.clear();
+            mOwners.clear();
+        }
+    private:
+        Vector<Slot> mSlots;
+        Vector<T> mValues;
+        Vector<uint32_t> mOwners;
+        uint32_t mFree = none;
+
+        uint32_t acquire() {
+            if (mFree != none) return std::exchange(mFree, mSlots[mFree].target);
+            if (mSlots.size() == none) throw std::length_error("SlotMap is full");
+            mSlots.push_back(Slot{none, 0});
+            return uint32_t(mSlots.size() - 1);
+        }
+    };
+}
@@ -25,12 +25,29 @@
 #include <ranges>
 #include <cstdint>
 #include <cstddef>
+#include <array>
 #include <cstring>
+#include <limits>
+#include <memory>
 #include <concepts>
 #include <algorithm>
 #include <type_traits>
 
 namespace kls {
+    /// <summary>
+    /// The extent of a view whose size is only known at runtime
+    /// </summary>
+    inline constexpr size_t dynamic_extent = std::numeric_limits<size_t>::max();
+
+    template<class T = void, size_t N = dynamic_extent>
+    class Span;
+
+    template<class T>
+    struct is_span : std::false_type {};
+
+    template<class T, size_t N>
+    struct is_span<Span<T, N>> : std::true_type {};
+
     /// <summary>
     /// Represents a non-owning contiguous span of memory that is capable of holding 'size' entries of 'T' typed data
     /// with the exception of T = void
@@ -40,17 +57,21 @@ namespace kls {
     /// This data-type implements the std::ranges::contiguous_range concept and provides size() for information
     /// </summary>
     /// <typeparam name="T"></typeparam>
-    template<class T = void>
+    template<class T, size_t N>
     class Span {
+        static_assert(N == dynamic_extent, "Span<void> has no fixed extent variant");
     public:
         template<class Range>
-        requires std::ranges::contiguous_range<Range>
+        requires std::ranges::contiguous_range<Range> && (!is_span<std::remove_cv_t<Range>>::value)
         constexpr Span(Range &range) noexcept: Span{std::ranges::data(range), std::ranges::size(range)} {}
+        template<class U, size_t M>
+        requires (std::same_as<U, T> && M != dynamic_extent) || (std::same_as<const U, T> && !std::is_const_v<U>)
+        constexpr Span(Span<U, M> o) noexcept: m_begin{o.data()}, m_size(o.size()) {}
         template<class U>
         requires std::integral<U>
         constexpr Span(T *data, U size) noexcept : m_begin{data}, m_size(size) {}
         template<class U>
-        requires std::integral<U>
+        requires std::integral<U> && (!std::is_const_v<T>)
         constexpr Span(const T *data, U size) noexcept : m_begin{const_cast<T *>(data)}, m_size(size) {}
         constexpr Span(Span &&) noexcept = default;
         constexpr Span(const Span &) noexcept = default;
@@ -79,12 +100,69 @@ namespace kls {
             if (size > m_size) size = m_size;
             return Span{m_begin + m_size - size, size};
         }
+        /// The span must hold at least M elements
+        template<size_t M>
+        [[nodiscard]] constexpr Span<T, M> keep_front() const noexcept { return Span<T, M>{m_begin}; }
+        /// The span must hold at least M elements
+        template<size_t M>
+        [[nodiscard]] constexpr Span<T, M> keep_back() const noexcept { return Span<T, M>{m_begin + m_size - M}; }
         constexpr operator Span<void>() const noexcept;
     private:
         T *m_begin;
         size_t m_size;
     };
 
+    /// <summary>
+    /// Represents a non-owning contiguous span of exactly N entries of 'T' typed data
+    ///
+    /// The size is part of the type, so the span is a single pointer and loops over it can be unrolled at compile time
+    /// Converts implicitly to the dynamic Span<T> and Span<>, the reverse conversion is explicit and takes the first N
+    /// entries of a span that must hold at least N
+    /// </summary>
+    template<class T, size_t N>
+    requires (N != dynamic_extent && !std::is_void_v<T>)
+    class Span<T, N> {
+    public:
+        static constexpr size_t extent = N;
+        constexpr explicit Span(T *data) noexcept: m_begin{data} {}
+        constexpr explicit Span(const T *data) noexcept requires (!std::is_const_v<T>): m_begin{const_cast<T *>(data)} {}
+        template<size_t M>
+        requires (M == N)
+        constexpr Span(T (&array)[M]) noexcept: m_begin{array} {} // NOLINT
+        constexpr Span(std::array<T, N> &array) noexcept: m_begin{array.data()} {} // NOLINT
+        constexpr explicit Span(Span<T> o) noexcept: m_begin{o.data()} {}
+        constexpr Span(Span &&) noexcept = default;
+        constexpr Span(const Span &) noexcept = default;
+        constexpr Span &operator=(Span &&) noexcept = default;
+        constexpr Span &operator=(const Span &) noexcept = default;
+        constexpr T *begin() noexcept { return m_begin; }
+        constexpr T *end() noexcept { return m_begin + N; }
+        constexpr const T *begin() const noexcept { return m_begin; }
+        constexpr const T *end() const noexcept { return m_begin + N; }
+        constexpr T *data() noexcept { return m_begin; }
+        constexpr const T *data() const noexcept { return m_begin; }
+        static constexpr size_t size() noexcept { return N; }
+        template<size_t M>
+        requires (M <= N)
+        [[nodiscard]] constexpr Span<T, N - M> trim_front() const noexcept { return Span<T, N - M>{m_begin + M}; }
+        template<size_t M>
+        requires (M <= N)
+        [[nodiscard]] constexpr Span<T, N - M> trim_back() const noexcept { return Span<T, N - M>{m_begin}; }
+        template<size_t M>
+        requires (M <= N)
+        [[nodiscard]] constexpr Span<T, M> keep_front() const noexcept { return Span<T, M>{m_begin}; }
+        template<size_t M>
+        requires (M <= N)
+        [[nodiscard]] constexpr Span<T, M> keep_back() const noexcept { return Span<T, M>{m_begin + N - M}; }
+        [[nodiscard]] Span<T> trim_front(size_t diff) const noexcept { return Span<T>(*this).trim_front(diff); }
+        [[nodiscard]] Span<T> trim_back(size_t diff) const noexcept { return Span<T>(*this).trim_back(diff); }
+        [[nodiscard]] Span<T> keep_front(size_t size) const noexcept { return Span<T>(*this).keep_front(size); }
+        [[nodiscard]] Span<T> keep_back(size_t size) const noexcept { return Span<T>(*this).keep_back(size); }
+        constexpr operator Span<void>() const noexcept;
+    private:
+        T *m_begin;
+    };
+
     /// <summary>
     /// Represents a non-owning contiguous span of memory consists of 'size' basic machine addressable units
     ///
@@ -129,8 +207,12 @@ namespace kls {
         size_t m_size;
     };
 
-    template<class T>
-    inline constexpr Span<T>::operator Span<void>() const noexcept { return Span<void>(m_begin, m_size * sizeof(T)); }
+    template<class T, size_t N>
+    inline constexpr Span<T, N>::operator Span<void>() const noexcept { return Span<void>(m_begin, m_size * sizeof(T)); }
+
+    template<class T, size_t N>
+    requires (N != dynamic_extent && !std::is_void_v<T>)
+    inline constexpr Span<T, N>::operator Span<void>() const noexcept { return Span<void>(m_begin, N * sizeof(T)); }
 
     /// <summary>
     /// The function performs a static_cast from Span<> regardless of the data alignment
@@ -184,6 +266,22 @@ namespace kls {
         return true;
     }
 
+    /// <summary>
+    /// Copy between spans of the same fixed extent, trivially copyable items are copied with a fixed size memcpy
+    /// </summary>
+    template<class T, size_t N>
+    requires (N != dynamic_extent)
+    constexpr bool copy(Span<T, N> src, Span<T, N> dst) noexcept(span_safely_copyable_type<T>) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (!std::is_constant_evaluated()) {
+                std::memmove(static_cast<void *>(dst.data()), src.data(), N * sizeof(T));
+                return true;
+            }
+        }
+        std::copy_n(src.begin(), N, dst.begin());
+        return true;
+    }
+
     template<class T>
     concept span_safely_movable_type = requires {
         (std::is_nothrow_move_assignable_v<T> && std::is_nothrow_move_constructible_v<T>);
@@ -203,10 +301,21 @@ namespace kls {
         return true;
     }
 
+    /// <summary>
+    /// Tells whether moving a T to a new address and destroying the old one is equivalent to copying its bytes
+    /// Trivially copyable types qualify, other types opt in by specializing this trait
+    /// </summary>
+    template<class T>
+    struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+    template<class T>
+    inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<std::remove_cv_t<T>>::value;
+
     /// <summary>
     /// Relocates the source span's items to the destination span
-    /// The implementation uses move constructor and destructs the old item immediately
-    /// The function assumes all entries of the destination span is valid items and source span contains no objects
+    /// Trivially relocatable items are moved with a single memmove, others are move constructed and the old item is
+    /// destructed immediately
+    /// The function assumes all entries of the source span are valid items and the destination span contains no objects
     /// </summary>
     /// <param name="src"> The source span </param>
     /// <param name="dest"> The destination span </param>
@@ -218,11 +327,17 @@ namespace kls {
     constexpr bool relocate(Span<T> src, Span<T> dst) noexcept {
         if (src.size() != dst.size()) return false;
         const auto size = dst.size();
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if (!std::is_constant_evaluated()) {
+                if (size) std::memmove(static_cast<void *>(dst.data()), src.data(), size * sizeof(T));
+                return true;
+            }
+        }
         for (size_t i = 0; i < size; ++i) {
-            T* o_src = src.data() + i, o_dst = dst.data() + i;
+            T *o_src = src.data() + i, *o_dst = dst.data() + i;
             std::construct_at(o_dst, std::move(*o_src));
             std::destroy_at(o_src);
         }
         return true;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,199 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <utility>
+#include <algorithm>
+#include <filesystem>
+#include "kls/Span.h"
+#include "kls/hal/System.h"
+#include "kls/essential/Unsafe.h"
+
+namespace kls::essential {
+    template<std::endian E>
+    class MappedReader;
+
+    /// <summary>
+    /// Read only memory mapping of a file, the content is read in place without copying it to the heap
+    /// Files larger than the address space budget are mapped one window at a time
+    /// </summary>
+    class MappedFile {
+    public:
+        static constexpr size_t WholeFile = SIZE_MAX;
+        static constexpr size_t DefaultReadAhead = 4u << 20u;
+
+        /// <summary>
+        /// Opens and maps the file, throws std::system_error if the file cannot be opened or mapped
+        /// </summary>
+        /// <param name="path"> The file to map </param>
+        /// <param name="budget"> The largest number of bytes mapped at a time </param>
+        /// <param name="sequential"> Whether the file is mostly read front to back, tells the kernel to read ahead </param>
+        explicit MappedFile(const std::filesystem::path &path, size_t budget = WholeFile, bool sequential = true);
+
+        MappedFile(const MappedFile &) = delete;
+
+        MappedFile(MappedFile &&o) noexcept;
+
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        MappedFile &operator=(MappedFile &&o) noexcept;
+
+        ~MappedFile() noexcept;
+
+        /// <summary>
+        /// The size of the file in bytes
+        /// </summary>
+        [[nodiscard]] size_t size() const noexcept { return m_size; }
+
+        /// <summary>
+        /// Whether the whole file is mapped at once
+        /// </summary>
+        [[nodiscard]] bool whole() const noexcept { return m_window_offset == 0 && m_window_size == m_size; }
+
+        /// <summary>
+        /// The mapped bytes, the whole file unless the file is larger than the budget
+        /// </summary>
+        [[nodiscard]] Span<> span() const noexcept { return {static_cast<const void *>(m_window), m_window_size}; }
+
+        /// <summary>
+        /// The offset in the file of the first mapped byte
+        /// </summary>
+        [[nodiscard]] size_t window_offset() const noexcept { return m_window_offset; }
+
+        /// <summary>
+        /// Makes the given range of the file addressable, moving the window if it is not mapped yet
+        /// Spans obtained before the window moved become invalid, throws std::system_error if remapping fails
+        /// </summary>
+        /// <returns> The bytes of the range, or an empty span if the range is not within the file </returns>
+        Span<> map(size_t offset, size_t size);
+
+        /// <summary>
+        /// Asks the system to start reading the mapped part of the given range in the background
+        /// </summary>
+        /// <returns> The end of the range that was requested, clamped to the window </returns>
+        size_t prefetch(size_t offset, size_t size) const noexcept;
+
+        /// <summary>
+        /// Reads the file from offset on, prefetching read_ahead bytes in front of the cursor
+        /// </summary>
+        template<std::endian E>
+        [[nodiscard]] MappedReader<E> reader(size_t offset = 0, size_t read_ahead = DefaultReadAhead) {
+            return MappedReader<E>(*this, offset, read_ahead);
+        }
+    private:
+#ifdef KLS_SYS_NTOS
+        HANDLE m_file{INVALID_HANDLE_VALUE}, m_mapping{nullptr};
+#else
+        int m_file{-1};
+#endif
+        char *m_window{nullptr};
+        size_t m_size{0}, m_budget, m_window_offset{0}, m_window_size{0};
+        bool m_sequential;
+
+        void remap(size_t offset, size_t size);
+
+        void unmap() noexcept;
+
+        void close() noexcept;
+    };
+
+    /// <summary>
+    /// SpanReader over a MappedFile that moves the window as it goes and keeps the read ahead in front of it
+    /// As with SpanReader, get, get_array and bytes do not check bounds, reserve or check first, those are the
+    /// points where the window moves and more of the file is prefetched
+    /// </summary>
+    template<std::endian E>
+    class MappedReader {
+    public:
+        MappedReader(MappedFile &file, size_t offset, size_t read_ahead = MappedFile::DefaultReadAhead):
+                m_file(&file), m_base(std::min(offset, file.size())), m_prefetched(m_base),
+                m_read_ahead(std::max(read_ahead, size_t(1))) {
+            refill(0);
+        }
+
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        [[nodiscard]] T get() noexcept { return m_reader.template get<T>(); }
+
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        void get_array(Span<T> dst) noexcept { m_reader.get_array(dst); }
+
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        [[nodiscard]] bool check(size_t count = 1) { return reserve(sizeof(T) * count); }
+
+        /// <summary>
+        /// Whether the next bytes are in the file, moves the window over them if needed
+        /// </summary>
+        [[nodiscard]] bool reserve(size_t bytes) {
+            if (!m_reader.reserve(bytes)) [[unlikely]] return refill(bytes);
+            if (offset() + m_read_ahead / 2 >= m_prefetched) [[unlikely]] pump();
+            return true;
+        }
+
+        [[nodiscard]] size_t offset() const noexcept { return m_base + m_reader.offset(); }
+
+        [[nodiscard]] size_t remaining() const noexcept { return m_file->size() - offset(); }
+
+        auto bytes(size_t size) noexcept { return m_reader.bytes(size); }
+
+        template<size_t N>
+        auto bytes() noexcept { return m_reader.template bytes<N>(); }
+
+        /// <summary>
+        /// Reads a LEB128 value, bounds checked
+        /// </summary>
+        [[nodiscard]] bool get_varint(uint64_t &value) {
+            return reserve(std::min(max_varint_size, remaining())) && m_reader.get_varint(value);
+        }
+
+        [[nodiscard]] bool get_svarint(int64_t &value) {
+            return reserve(std::min(max_varint_size, remaining())) && m_reader.get_svarint(value);
+        }
+    private:
+        MappedFile *m_file;
+        SpanReader<E> m_reader{Span<>(static_cast<void *>(nullptr), size_t(0))};
+        size_t m_base, m_prefetched, m_read_ahead;
+
+        // restarts the reader at the cursor, with the window moved over the next bytes if they are not mapped
+        bool refill(size_t bytes) {
+            const auto cursor = offset();
+            if (bytes > m_file->size() - cursor) return false;
+            m_file->map(cursor, bytes);
+            const auto window = m_file->span();
+            const auto start = cursor - m_file->window_offset();
+            m_reader = SpanReader<E>(window.trim_front(start));
+            m_base = cursor;
+            m_prefetched = std::max(m_prefetched, cursor);
+            pump();
+            return true;
+        }
+
+        void pump() noexcept {
+            const auto end = std::min(offset() + m_read_ahead, m_file->size());
+            if (end > m_prefetched) m_prefetched = m_file->prefetch(m_prefetched, end - m_prefetched);
+        }
+    };
+}
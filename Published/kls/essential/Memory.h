@@ -56,7 +56,7 @@ namespace kls::essential {
     /// <summary>
     /// Obtains a 4MiB memory block that is alligned to 4MiB from the library's memory management system
     /// </summary>
-    /// <returns> The staring address of the block in uintptr_t </returns>
+    /// <returns> The staring address of the block in uintptr_t, or 0 if the reserved address space is exhausted </returns>
     uintptr_t rent_4m_block() noexcept;
 
     /// <summary>
@@ -65,4 +65,11 @@ namespace kls::essential {
     /// <param name="block"> The exact value returned from the relavent rent_4m_block() </param>
     /// <returns> None </returns>
     void return_4m_block(uintptr_t block) noexcept;
+
+    /// <summary>
+    /// Checks if an address lies within the address space from which rent_4m_block() hands out blocks
+    /// </summary>
+    /// <param name="address"> The address to check </param>
+    /// <returns> True if the address may belong to a rented block </returns>
+    bool is_4m_block_address(uintptr_t address) noexcept;
 }
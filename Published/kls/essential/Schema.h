@@ -0,0 +1,201 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <array>
+#include <tuple>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+#include "kls/Span.h"
+#include "kls/essential/Unsafe.h"
+
+namespace kls::essential {
+    namespace detail {
+        template<class M>
+        struct MemberTraits;
+
+        template<class C, class T>
+        struct MemberTraits<T C::*> {
+            using Class = C;
+            using Type = T;
+        };
+
+        template<class T>
+        struct DefaultWire { using type = T; };
+
+        template<class T>
+        requires std::is_enum_v<T>
+        struct DefaultWire<T> { using type = std::underlying_type_t<T>; };
+    }
+
+    /// <summary>
+    /// One field of a Schema: the member it is stored in and the arithmetic type it has on the wire
+    /// Enums go on the wire as their underlying type, other wire types are reached with static_cast
+    /// </summary>
+    template<auto Member, class Wire = typename detail::DefaultWire<
+            typename detail::MemberTraits<decltype(Member)>::Type>::type>
+    struct Field {
+        using Class = typename detail::MemberTraits<decltype(Member)>::Class;
+        using Type = typename detail::MemberTraits<decltype(Member)>::Type;
+        using WireType = Wire;
+        static constexpr auto member = Member;
+        static constexpr size_t wire_size = sizeof(Wire);
+
+        static_assert(std::is_arithmetic_v<Wire>, "Wire types must be arithmetic");
+
+        /// <summary>
+        /// Whether the member holds exactly its wire bytes in E byte order, so that it can be copied as is
+        /// </summary>
+        template<std::endian E>
+        static constexpr bool raw = std::is_same_v<typename detail::DefaultWire<Type>::type, Wire> &&
+                                    (E == std::endian::native || sizeof(Wire) == 1);
+    };
+
+    /// <summary>
+    /// Fixed size message layout given as a list of fields, the fields are packed on the wire in the given order
+    /// Writers and readers check the buffer once per message, then runs of fields that are stored back to back in
+    /// the struct and need no conversion are copied with one memcpy each
+    /// </summary>
+    template<class... Fields>
+    class Schema {
+        using First = std::tuple_element_t<0, std::tuple<Fields...>>;
+    public:
+        using Class = typename First::Class;
+        static_assert((std::is_same_v<typename Fields::Class, Class> && ...), "All fields must belong to one class");
+
+        static constexpr size_t count = sizeof...(Fields);
+
+        /// <summary>
+        /// The number of bytes of one message on the wire
+        /// </summary>
+        static constexpr size_t wire_size = (Fields::wire_size + ...);
+
+        /// <summary>
+        /// Stores v into exactly wire_size bytes
+        /// </summary>
+        template<std::endian E>
+        static void encode(Span<char, wire_size> out, const Class &v) noexcept { encode_from<E, 0>(out.data(), v); }
+
+        template<std::endian E>
+        static void decode(Span<char, wire_size> in, Class &v) noexcept { decode_from<E, 0>(in.data(), v); }
+
+        /// <summary>
+        /// Appends v to a SpanWriter or StreamWriter
+        /// </summary>
+        /// <returns> false without writing if the writer has no room for the message </returns>
+        template<template<std::endian> class Writer, std::endian E>
+        static bool write(Writer<E> &writer, const Class &v) {
+            if (!writer.reserve(wire_size)) return false;
+            encode<E>(writer.template bytes<wire_size>(), v);
+            return true;
+        }
+
+        /// <summary>
+        /// Reads the next message from a SpanReader or MappedReader into v
+        /// </summary>
+        /// <returns> false without reading if the message is truncated </returns>
+        template<template<std::endian> class Reader, std::endian E>
+        static bool read(Reader<E> &reader, Class &v) {
+            if (!reader.reserve(wire_size)) return false;
+            decode<E>(reader.template bytes<wire_size>(), v);
+            return true;
+        }
+    private:
+        using List = std::tuple<Fields...>;
+
+        template<size_t I>
+        using At = std::tuple_element_t<I, List>;
+
+        static constexpr std::array<size_t, count + 1> wire_offsets = [] {
+            std::array<size_t, count + 1> result{};
+            constexpr size_t sizes[] = {Fields::wire_size...};
+            for (size_t i = 0; i < count; ++i) result[i + 1] = result[i] + sizes[i];
+            return result;
+        }();
+
+        // one past the last field of the run of raw fields that starts at I
+        template<std::endian E, size_t I>
+        static constexpr size_t run_end() noexcept {
+            if constexpr(I < count) {
+                if constexpr(At<I>::template raw<E>) return run_end<E, I + 1>();
+                else return I;
+            } else {
+                return I;
+            }
+        }
+
+        template<size_t I>
+        static size_t member_offset(const Class &v) noexcept {
+            return size_t(reinterpret_cast<const char *>(&(v.*At<I>::member)) - reinterpret_cast<const char *>(&v));
+        }
+
+        // a run is stored in one piece if each member directly follows the previous one, which the compiler folds
+        template<size_t I, size_t J>
+        static bool contiguous(const Class &v) noexcept {
+            return [&v]<size_t... K>(std::index_sequence<K...>) {
+                return ((member_offset<I + K + 1>(v) == member_offset<I + K>(v) + At<I + K>::wire_size) && ...);
+            }(std::make_index_sequence<J - I - 1>{});
+        }
+
+        template<std::endian E, size_t I>
+        static void encode_from(char *out, const Class &v) noexcept {
+            if constexpr(I < count) {
+                constexpr auto J = run_end<E, I>();
+                if constexpr(J > I + 1 && std::is_trivially_copyable_v<Class>) {
+                    if (contiguous<I, J>(v)) {
+                        const auto source = reinterpret_cast<const char *>(&v) + member_offset<I>(v);
+                        std::memcpy(out + wire_offsets[I], source, wire_offsets[J] - wire_offsets[I]);
+                        return encode_from<E, J>(out, v);
+                    }
+                }
+                using Wire = typename At<I>::WireType;
+                auto value = static_cast<Wire>(v.*At<I>::member);
+                if constexpr(sizeof(Wire) > 1 && std::endian::native != E) byte_swap(value);
+                std::memcpy(out + wire_offsets[I], &value, sizeof(Wire));
+                encode_from<E, I + 1>(out, v);
+            }
+        }
+
+        template<std::endian E, size_t I>
+        static void decode_from(const char *in, Class &v) noexcept {
+            if constexpr(I < count) {
+                constexpr auto J = run_end<E, I>();
+                if constexpr(J > I + 1 && std::is_trivially_copyable_v<Class>) {
+                    if (contiguous<I, J>(v)) {
+                        const auto target = reinterpret_cast<char *>(&v) + member_offset<I>(v);
+                        std::memcpy(target, in + wire_offsets[I], wire_offsets[J] - wire_offsets[I]);
+                        return decode_from<E, J>(in, v);
+                    }
+                }
+                using Wire = typename At<I>::WireType;
+                Wire value;
+                std::memcpy(&value, in + wire_offsets[I], sizeof(Wire));
+                if constexpr(sizeof(Wire) > 1 && std::endian::native != E) byte_swap(value);
+                v.*At<I>::member = static_cast<typename At<I>::Type>(value);
+                decode_from<E, I + 1>(in, v);
+            }
+        }
+    };
+}
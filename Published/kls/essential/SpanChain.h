@@ -0,0 +1,284 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <bit>
+#include <new>
+#include <memory>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+#include "kls/Span.h"
+#include "kls/hal/System.h"
+#include "kls/pmr/Vector.h"
+#include "kls/essential/Unsafe.h"
+
+#ifndef KLS_SYS_NTOS
+#include <sys/uio.h>
+#endif
+
+namespace kls::essential {
+    /// <summary>
+    /// Ordered list of byte segments that form one logical message, for vectored I/O without a gather copy
+    /// The first InlineSegments segments are stored in place, longer chains spill to the allocator
+    /// </summary>
+    class SpanChain {
+    public:
+        static constexpr size_t InlineSegments = 8;
+        using allocator_type = pmr::PolymorphicAllocator<Span<>>;
+
+        /// <summary>
+        /// A byte position in the chain, as the index of a segment and the offset into it
+        /// </summary>
+        struct Cursor {
+            size_t segment{0};
+            size_t offset{0};
+        };
+
+        SpanChain() noexcept = default;
+
+        explicit SpanChain(allocator_type alloc) noexcept: mSpill(alloc) {}
+
+        SpanChain(std::initializer_list<Span<>> segments, allocator_type alloc = {}): mSpill(alloc) {
+            for (auto &&segment: segments) append(segment);
+        }
+
+        SpanChain(const SpanChain &o): mSpill(o.mSpill.get_allocator()) { for (auto &&segment: o) append(segment); }
+
+        SpanChain(SpanChain &&o) noexcept:
+                mSpill(std::move(o.mSpill)), mCount(std::exchange(o.mCount, 0)), mBytes(std::exchange(o.mBytes, 0)) {
+            std::memcpy(mInline, o.mInline, sizeof(mInline));
+        }
+
+        SpanChain &operator=(const SpanChain &o) {
+            if (&o != this) {
+                clear();
+                for (auto &&segment: o) append(segment);
+            }
+            return *this;
+        }
+
+        SpanChain &operator=(SpanChain &&o) {
+            if (&o != this) {
+                std::memcpy(mInline, o.mInline, sizeof(mInline));
+                mSpill = std::move(o.mSpill);
+                mCount = std::exchange(o.mCount, 0);
+                mBytes = std::exchange(o.mBytes, 0);
+                o.mSpill.clear();
+            }
+            return *this;
+        }
+
+        /// <summary>
+        /// Adds a segment to the end of the chain, empty segments are dropped
+        /// </summary>
+        SpanChain &append(Span<> segment) {
+            if (!segment.size()) return *this;
+            if (mCount < InlineSegments) {
+                std::construct_at(inline_segments() + mCount, segment);
+            } else {
+                if (mCount == InlineSegments) spill();
+                mSpill.push_back(segment);
+            }
+            ++mCount;
+            mBytes += segment.size();
+            return *this;
+        }
+
+        void clear() noexcept {
+            mSpill.clear();
+            mCount = mBytes = 0;
+        }
+
+        /// <summary>
+        /// The number of segments
+        /// </summary>
+        [[nodiscard]] size_t count() const noexcept { return mCount; }
+
+        /// <summary>
+        /// The number of bytes over all segments
+        /// </summary>
+        [[nodiscard]] size_t size() const noexcept { return mBytes; }
+
+        [[nodiscard]] bool empty() const noexcept { return mCount == 0; }
+
+        const Span<> *begin() const noexcept { return mCount <= InlineSegments ? inline_segments() : mSpill.data(); }
+
+        const Span<> *end() const noexcept { return begin() + mCount; }
+
+        const Span<> &operator[](size_t index) const noexcept { return begin()[index]; }
+
+        /// <summary>
+        /// Copies the whole chain into dst, returns false without copying if dst is too small
+        /// </summary>
+        bool copy_to(Span<> dst) const noexcept {
+            if (dst.size() < mBytes) return false;
+            auto cursor = static_cast<char *>(dst.data());
+            for (auto &&segment: *this) cursor = std::copy_n(static_cast<const char *>(segment.data()), segment.size(), cursor);
+            return true;
+        }
+
+        /// <summary>
+        /// Moves a cursor forward by the given number of bytes, only the segments passed over are visited
+        /// </summary>
+        [[nodiscard]] Cursor advance(Cursor at, size_t bytes) const noexcept {
+            const auto segments = begin();
+            bytes += at.offset;
+            while (at.segment < mCount && bytes >= segments[at.segment].size()) bytes -= segments[at.segment++].size();
+            return {at.segment, at.segment < mCount ? bytes : 0};
+        }
+
+#ifndef KLS_SYS_NTOS
+        /// <summary>
+        /// Describes the bytes from the cursor on as iovec entries
+        /// </summary>
+        /// <returns> The number of entries filled, less than the remaining segments if out is too small </returns>
+        size_t to_iovec(Span<iovec> out, Cursor from) const noexcept {
+            const auto segments = begin();
+            size_t filled = 0;
+            for (auto i = from.segment; i < mCount && filled < out.size(); ++i, from.offset = 0) {
+                auto &&entry = out.data()[filled++];
+                entry.iov_base = static_cast<char *>(const_cast<void *>(segments[i].data())) + from.offset;
+                entry.iov_len = segments[i].size() - from.offset;
+            }
+            return filled;
+        }
+
+        /// <summary>
+        /// Describes the bytes after the first skip bytes as iovec entries
+        /// Resumed transfers should keep a Cursor instead, this walks the chain from the start
+        /// </summary>
+        size_t to_iovec(Span<iovec> out, size_t skip = 0) const noexcept { return to_iovec(out, advance({}, skip)); }
+#endif
+    private:
+        alignas(Span<>) unsigned char mInline[InlineSegments * sizeof(Span<>)];
+        pmr::Vector<Span<>> mSpill{};
+        size_t mCount{0}, mBytes{0};
+
+        Span<> *inline_segments() noexcept { return std::launder(reinterpret_cast<Span<> *>(mInline)); }
+
+        const Span<> *inline_segments() const noexcept {
+            return std::launder(reinterpret_cast<const Span<> *>(mInline));
+        }
+
+        void spill() {
+            mSpill.reserve(InlineSegments * 2);
+            for (size_t i = 0; i < InlineSegments; ++i) mSpill.push_back(inline_segments()[i]);
+        }
+    };
+
+    /// <summary>
+    /// Reads arithmetic values and bytes from a SpanChain, values may straddle segment boundaries
+    /// </summary>
+    template<std::endian E>
+    class SpanChainReader {
+    public:
+        explicit SpanChainReader(const SpanChain &chain) noexcept: m_chain(&chain) { settle(); }
+
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        [[nodiscard]] T get() noexcept {
+            T result{};
+            if (m_current.size() >= sizeof(T)) {
+                std::memcpy(&result, m_current.data(), sizeof(T));
+                advance(sizeof(T));
+            } else {
+                read(Span<>(&result, sizeof(T)));
+            }
+            if constexpr(sizeof(T) > 1 && std::endian::native != E) byte_swap(result);
+            return result;
+        }
+
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        [[nodiscard]] bool check(size_t count = 1) const noexcept { return sizeof(T) * count <= remaining(); }
+
+        /// <summary>
+        /// Copies the next bytes into dst, returns the number of bytes copied
+        /// </summary>
+        size_t read(Span<> dst) noexcept {
+            auto cursor = static_cast<char *>(dst.data());
+            size_t left = std::min(dst.size(), remaining());
+            const auto result = left;
+            while (left) {
+                const auto step = std::min(left, m_current.size());
+                cursor = std::copy_n(static_cast<const char *>(m_current.data()), step, cursor);
+                advance(step);
+                left -= step;
+            }
+            return result;
+        }
+
+        /// <summary>
+        /// Advances over the next bytes, returns the number of bytes skipped
+        /// </summary>
+        size_t skip(size_t size) noexcept {
+            size_t left = std::min(size, remaining());
+            const auto result = left;
+            while (left) {
+                const auto step = std::min(left, m_current.size());
+                advance(step);
+                left -= step;
+            }
+            return result;
+        }
+
+        /// <summary>
+        /// The unread part of the current segment, available without copying
+        /// </summary>
+        [[nodiscard]] Span<> contiguous() const noexcept { return m_current; }
+
+        [[nodiscard]] size_t remaining() const noexcept { return m_chain->size() - m_offset; }
+
+        [[nodiscard]] size_t offset() const noexcept { return m_offset; }
+    private:
+        const SpanChain *m_chain;
+        Span<> m_current{static_cast<void *>(nullptr), size_t(0)};
+        size_t m_segment{0}, m_offset{0};
+
+        void advance(size_t size) noexcept {
+            m_current = m_current.trim_front(size);
+            m_offset += size;
+            settle();
+        }
+
+        void settle() noexcept {
+            while (!m_current.size() && m_segment < m_chain->count()) m_current = (*m_chain)[m_segment++];
+        }
+    };
+
+#ifndef KLS_SYS_NTOS
+    /// <summary>
+    /// Writes the whole chain to fd with writev, continuing after partial writes and interrupts
+    /// </summary>
+    /// <returns> The number of bytes written, or -1 with errno set if nothing could be written </returns>
+    ptrdiff_t writev(int fd, const SpanChain &chain) noexcept;
+
+    /// <summary>
+    /// Fills the segments of the chain in order from fd with readv, until the chain is full or end of file
+    /// </summary>
+    /// <returns> The number of bytes read, or -1 with errno set if nothing could be read </returns>
+    ptrdiff_t readv(int fd, const SpanChain &chain) noexcept;
+#endif
+}
@@ -0,0 +1,206 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <utility>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+#include "kls/Span.h"
+#include "kls/pmr/Vector.h"
+#include "kls/essential/Unsafe.h"
+#include "kls/essential/SpanChain.h"
+
+namespace kls::essential {
+    namespace detail {
+        /// <summary>
+        /// The segment bookkeeping behind StreamWriter, segments are never moved once written to
+        /// Segments double from the initial size while they fit the temp allocator, then 4MiB blocks are rented
+        /// </summary>
+        class StreamSegments {
+        public:
+            static constexpr size_t InitialSegment = 4u << 10u;
+
+            explicit StreamSegments(size_t initial = InitialSegment) noexcept: m_next(std::max(initial, size_t(64))) {}
+
+            StreamSegments(const StreamSegments &) = delete;
+
+            StreamSegments(StreamSegments &&o) noexcept:
+                    m_cursor(std::exchange(o.m_cursor, nullptr)), m_limit(std::exchange(o.m_limit, nullptr)),
+                    m_closed(std::exchange(o.m_closed, 0)), m_next(o.m_next), m_segments(std::move(o.m_segments)) {}
+
+            StreamSegments &operator=(const StreamSegments &) = delete;
+
+            StreamSegments &operator=(StreamSegments &&o) noexcept;
+
+            ~StreamSegments() noexcept { release(); }
+
+            /// <summary>
+            /// The number of bytes written so far
+            /// </summary>
+            [[nodiscard]] size_t offset() const noexcept {
+                return m_segments.empty() ? 0 : m_closed + size_t(m_cursor - m_segments.back().base);
+            }
+
+            /// <summary>
+            /// The number of bytes that can be written before the next segment is started
+            /// </summary>
+            [[nodiscard]] size_t remaining() const noexcept { return size_t(m_limit - m_cursor); }
+
+            /// <summary>
+            /// Makes the next bytes contiguous, starting a new segment if the current one has no room for them
+            /// One reserve covers all fields of a record written afterwards, always returns true
+            /// </summary>
+            bool reserve(size_t bytes) {
+                if (remaining() < bytes) [[unlikely]] grow(bytes);
+                return true;
+            }
+
+            /// <summary>
+            /// Appends the bytes, filling the current segment before starting the next one
+            /// </summary>
+            void write(Span<> data);
+
+            /// <summary>
+            /// The bytes written so far as a scatter list, valid until the next write, flatten or clear
+            /// </summary>
+            [[nodiscard]] SpanChain written() const;
+
+            /// <summary>
+            /// Copies all bytes into dst, returns false without copying if dst is too small
+            /// </summary>
+            bool copy_to(Span<> dst) const noexcept;
+
+            /// <summary>
+            /// Joins the written bytes into one segment, copying only if more than one segment is in use
+            /// Writing may continue afterwards, the result is valid until the next write, flatten or clear
+            /// </summary>
+            Span<> flatten();
+
+            /// <summary>
+            /// Drops everything written and releases all segments
+            /// </summary>
+            void clear() noexcept;
+        protected:
+            char *m_cursor{nullptr}, *m_limit{nullptr};
+
+            // closes the current segment and starts one with room for at least size bytes
+            void grow(size_t size);
+        private:
+            struct Segment {
+                char *base;
+                size_t capacity, used;
+                bool rented;
+            };
+
+            size_t m_closed{0}, m_next;
+            pmr::Vector<Segment> m_segments{};
+
+            static Segment allocate(size_t capacity);
+
+            void release() noexcept;
+        };
+    }
+
+    /// <summary>
+    /// SpanWriter that needs no size up front, it writes into a chain of segments that grows without copying
+    /// The content is handed out as a scatter list by written(), or joined into one span by flatten()
+    /// </summary>
+    template<std::endian E>
+    class StreamWriter: public detail::StreamSegments {
+    public:
+        using StreamSegments::StreamSegments;
+
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        void put(T v) {
+            if constexpr(sizeof(T) > 1 && std::endian::native != E) byte_swap(v);
+            if (remaining() < sizeof(T)) [[unlikely]] return write(Span<>(&v, sizeof(T)));
+            std::memcpy(m_cursor, &v, sizeof(T));
+            m_cursor += sizeof(T);
+        }
+
+        /// <summary>
+        /// Writes all values of the array, one copy per segment, values never straddle segments
+        /// </summary>
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        void put_array(Span<const T> values) {
+            while (values.size()) {
+                const auto take = std::min(values.size(), remaining() / sizeof(T));
+                if (!take) {
+                    grow(sizeof(T));
+                    continue;
+                }
+                Access<E>(Span<>(m_cursor, take * sizeof(T))).put_array(0, values.keep_front(take));
+                m_cursor += take * sizeof(T);
+                values = values.trim_front(take);
+            }
+        }
+
+        template<class T>
+        requires std::is_arithmetic_v<T> && (!std::is_const_v<T>)
+        void put_array(Span<T> values) { put_array(Span<const T>(values)); }
+
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        bool check(size_t count = 1) { return reserve(sizeof(T) * count); }
+
+        auto bytes(size_t size) {
+            reserve(size);
+            return Span<char>{std::exchange(m_cursor, m_cursor + size), size};
+        }
+
+        template<size_t N>
+        auto bytes() {
+            reserve(N);
+            return Span<char, N>{std::exchange(m_cursor, m_cursor + N)};
+        }
+
+        /// <summary>
+        /// Writes v as LEB128
+        /// </summary>
+        void put_varint(uint64_t v) {
+            for (; v >= 0x80; v >>= 7) put(uint8_t(v | 0x80));
+            put(uint8_t(v));
+        }
+
+        /// <summary>
+        /// Writes v zigzag encoded as LEB128
+        /// </summary>
+        void put_svarint(int64_t v) { put_varint(zigzag_encode(v)); }
+
+        void put_varints(Span<const uint32_t> values) { for (auto v: values) put_varint(v); }
+
+        /// <summary>
+        /// Writes the size of data as LEB128 followed by the bytes
+        /// </summary>
+        void put_prefixed(Span<> data) {
+            put_varint(data.size());
+            write(data);
+        }
+
+        void put_string(std::string_view text) { put_prefixed(Span<>(text.data(), text.size())); }
+    };
+}
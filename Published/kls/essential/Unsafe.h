@@ -23,6 +23,11 @@
 #pragma once
 
 #include <bit>
+#include <cstdint>
+#include <concepts>
+#include <algorithm>
+#include <string_view>
+#include <type_traits>
 #include "kls/Span.h"
 
 #if defined(_MSC_VER) && (!defined(__clang__) || defined(__c2__))
@@ -52,14 +57,84 @@ namespace kls::essential {
     template<class T>
     requires std::is_arithmetic_v<T>
     void byte_swap(T &v) noexcept {
+        // floating point values are swapped through their bit pattern, never through a value conversion
+        if constexpr(std::is_floating_point_v<T>) {
+            using U = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+            auto bits = std::bit_cast<U>(v);
+            byte_swap(bits);
+            return void(v = std::bit_cast<T>(bits));
+        }
 #ifndef KLS_ENDIAN_NO_INTRINSICS
-        if constexpr(sizeof(T) == 2) return void(v = KLS_ENDIAN_INTRINSIC_BYTE_SWAP_2(v));
-        if constexpr(sizeof(T) == 4) return void(v = KLS_ENDIAN_INTRINSIC_BYTE_SWAP_4(v));
-        if constexpr(sizeof(T) == 8) return void(v = KLS_ENDIAN_INTRINSIC_BYTE_SWAP_8(v));
+        if constexpr(sizeof(T) == 2) return void(v = T(KLS_ENDIAN_INTRINSIC_BYTE_SWAP_2(v)));
+        if constexpr(sizeof(T) == 4) return void(v = T(KLS_ENDIAN_INTRINSIC_BYTE_SWAP_4(v)));
+        if constexpr(sizeof(T) == 8) return void(v = T(KLS_ENDIAN_INTRINSIC_BYTE_SWAP_8(v)));
 #endif
         T temp = v;
-        char *src = static_cast<char *>(&temp), *dst = static_cast<char *>(&v) + sizeof(T) - 1;
-        for (int i = 0; i < sizeof(T); ++i) dst[-i] = src[i];
+        auto src = reinterpret_cast<const char *>(&temp);
+        auto dst = reinterpret_cast<char *>(&v) + sizeof(T) - 1;
+        for (size_t i = 0; i < sizeof(T); ++i) dst[-ptrdiff_t(i)] = src[i];
+    }
+
+    namespace detail {
+        /// <summary>
+        /// Stores count values of size bytes from src into dst with their bytes reversed, dst may equal src
+        /// Runs on pshufb kernels at the simd level in use
+        /// </summary>
+        void byte_swap(void *dst, const void *src, size_t count, size_t size) noexcept;
+    }
+
+    /// <summary>
+    /// Reverses the bytes of every value in place
+    /// </summary>
+    template<class T>
+    requires std::is_arithmetic_v<T>
+    void byte_swap(Span<T> values) noexcept {
+        if constexpr(sizeof(T) > 1) detail::byte_swap(values.data(), values.data(), values.size(), sizeof(T));
+    }
+
+    /// <summary>
+    /// Copies values stored in From byte order into dst in To byte order
+    /// </summary>
+    /// <returns> If both spans have same size returns true, otherwise false</returns>
+    template<std::endian From, std::endian To, class T>
+    requires std::is_arithmetic_v<T>
+    bool convert_endian(std::type_identity_t<Span<const T>> src, Span<T> dst) noexcept {
+        if (src.size() != dst.size()) return false;
+        if constexpr(From == To || sizeof(T) == 1) {
+            if (src.size()) std::memmove(dst.data(), src.data(), src.size() * sizeof(T));
+        } else {
+            detail::byte_swap(dst.data(), src.data(), src.size(), sizeof(T));
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Maps signed values to unsigned ones so that values of small magnitude stay small: 0, -1, 1, -2 -> 0, 1, 2, 3
+    /// </summary>
+    template<std::signed_integral T>
+    constexpr std::make_unsigned_t<T> zigzag_encode(T v) noexcept {
+        using U = std::make_unsigned_t<T>;
+        return (U(v) << 1) ^ U(v >> (sizeof(T) * 8 - 1));
+    }
+
+    template<std::unsigned_integral U>
+    constexpr std::make_signed_t<U> zigzag_decode(U v) noexcept {
+        return std::make_signed_t<U>((v >> 1) ^ (0 - (v & 1)));
+    }
+
+    /// <summary>
+    /// The number of bytes of the LEB128 encoding of v
+    /// </summary>
+    constexpr size_t varint_size(uint64_t v) noexcept { return v ? (std::bit_width(v) + 6) / 7 : 1; }
+
+    inline constexpr size_t max_varint_size = 10;
+
+    namespace detail {
+        /// <summary>
+        /// Decodes count LEB128 values of at most 32 bits from the first bytes of src
+        /// </summary>
+        /// <returns> The number of bytes consumed, or SIZE_MAX if src is truncated or holds an invalid value </returns>
+        size_t decode_varints(const void *src, size_t bytes, uint32_t *dst, size_t count) noexcept;
     }
 
     template<std::endian E>
@@ -69,7 +144,7 @@ namespace kls::essential {
 
         template<class T>
         requires std::is_arithmetic_v<T>
-        void put(int offset, T v) noexcept {
+        void put(size_t offset, T v) noexcept {
             if constexpr(sizeof(T) == 1) {
                 *pointer(offset) = char(v);
             } else {
@@ -80,7 +155,7 @@ namespace kls::essential {
 
         template<class T>
         requires std::is_arithmetic_v<T>
-        [[nodiscard]] T get(int offset) const noexcept {
+        [[nodiscard]] T get(size_t offset) const noexcept {
             if constexpr(sizeof(T) == 1) {
                 return T(*pointer(offset));
             } else {
@@ -91,13 +166,41 @@ namespace kls::essential {
             }
         }
 
-        auto bytes(int offset, int size) const noexcept { return Span<char>{pointer(offset), size}; }
+        /// <summary>
+        /// Writes the whole array with one copy, swapping the bytes of the written copy when the endianness differs
+        /// </summary>
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        void put_array(size_t offset, Span<const T> values) noexcept {
+            if (!values.size()) return;
+            std::memcpy(pointer(offset), values.data(), values.size() * sizeof(T));
+            if constexpr(sizeof(T) > 1 && std::endian::native != E) {
+                detail::byte_swap(pointer(offset), pointer(offset), values.size(), sizeof(T));
+            }
+        }
+
+        /// <summary>
+        /// Reads dst.size() values with one copy, swapping their bytes in place when the endianness differs
+        /// </summary>
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        void get_array(size_t offset, Span<T> dst) const noexcept {
+            if (!dst.size()) return;
+            std::memcpy(dst.data(), pointer(offset), dst.size() * sizeof(T));
+            if constexpr(sizeof(T) > 1 && std::endian::native != E) {
+                detail::byte_swap(dst.data(), dst.data(), dst.size(), sizeof(T));
+            }
+        }
+
+        auto bytes(size_t offset, size_t size) const noexcept { return Span<char>{pointer(offset), size}; }
+        template<size_t N>
+        auto bytes(size_t offset) const noexcept { return Span<char, N>{pointer(offset)}; }
         auto size() const noexcept { return m_span.size(); }
     private:
         Span<char> m_span;
 
-        [[nodiscard]] char *pointer(int index) noexcept { return m_span.data() + index; }
-        [[nodiscard]] const char *pointer(int index) const noexcept { return m_span.data() + index; }
+        [[nodiscard]] char *pointer(size_t index) noexcept { return m_span.data() + index; }
+        [[nodiscard]] const char *pointer(size_t index) const noexcept { return m_span.data() + index; }
     };
 
     template<std::endian E>
@@ -113,19 +216,105 @@ namespace kls::essential {
             return res;
         }
 
+        /// <summary>
+        /// Fills dst with the next dst.size() values
+        /// </summary>
         template<class T>
         requires std::is_arithmetic_v<T>
-        [[nodiscard]] bool check(int count = 1) const noexcept {
-            return (m_offset + sizeof(T) * count) <= m_access.size();
+        void get_array(Span<T> dst) noexcept {
+            m_access.get_array(m_offset, dst);
+            m_offset += dst.size() * sizeof(T);
         }
 
-        auto bytes(int size) noexcept {
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        [[nodiscard]] bool check(size_t count = 1) const noexcept { return reserve(sizeof(T) * count); }
+
+        /// <summary>
+        /// Whether the next bytes are available, one check covers all fields of a record read afterwards
+        /// </summary>
+        [[nodiscard]] bool reserve(size_t bytes) const noexcept { return bytes <= m_access.size() - m_offset; }
+
+        [[nodiscard]] size_t offset() const noexcept { return m_offset; }
+
+        [[nodiscard]] size_t remaining() const noexcept { return m_access.size() - m_offset; }
+
+        auto bytes(size_t size) noexcept {
             auto span = m_access.bytes(m_offset, size);
             return (m_offset += size, span);
         }
+
+        template<size_t N>
+        auto bytes() noexcept {
+            auto span = m_access.template bytes<N>(m_offset);
+            return (m_offset += N, span);
+        }
+
+        /// <summary>
+        /// Reads a LEB128 value, bounds checked
+        /// </summary>
+        /// <returns> false without advancing if the data is truncated or the value does not fit 64 bits </returns>
+        [[nodiscard]] bool get_varint(uint64_t &value) noexcept {
+            uint64_t result = 0;
+            const auto end = std::min(m_access.size(), m_offset + max_varint_size);
+            for (size_t i = m_offset, shift = 0; i < end; ++i, shift += 7) {
+                const auto byte = m_access.template get<uint8_t>(i);
+                if (shift == 63 && byte > 1) return false;
+                result |= uint64_t(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    value = result;
+                    m_offset = i + 1;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// <summary>
+        /// Reads a zigzag encoded LEB128 value
+        /// </summary>
+        [[nodiscard]] bool get_svarint(int64_t &value) noexcept {
+            uint64_t raw;
+            if (!get_varint(raw)) return false;
+            value = zigzag_decode(raw);
+            return true;
+        }
+
+        /// <summary>
+        /// Fills dst with LEB128 values, bounds checked, decoding blocks of small values with SIMD
+        /// </summary>
+        /// <returns> false without advancing if the data is truncated or a value does not fit 32 bits </returns>
+        [[nodiscard]] bool get_varints(Span<uint32_t> dst) noexcept {
+            const auto used = detail::decode_varints(
+                    m_access.bytes(m_offset, remaining()).data(), remaining(), dst.data(), dst.size()
+            );
+            if (used == SIZE_MAX) return false;
+            m_offset += used;
+            return true;
+        }
+
+        /// <summary>
+        /// Reads a LEB128 length followed by that many bytes, the result points into the underlying buffer
+        /// </summary>
+        /// <returns> false without advancing if the data is truncated </returns>
+        [[nodiscard]] bool get_prefixed(Span<char> &out) noexcept {
+            const auto start = m_offset;
+            uint64_t size;
+            if (!get_varint(size)) return false;
+            if (size > remaining()) return (m_offset = start, false);
+            out = bytes(size_t(size));
+            return true;
+        }
+
+        [[nodiscard]] bool get_string(std::string_view &out) noexcept {
+            Span<char> view{static_cast<char *>(nullptr), 0};
+            if (!get_prefixed(view)) return false;
+            out = std::string_view(view.data(), view.size());
+            return true;
+        }
     private:
         Access<E> m_access;
-        int m_offset{0};
+        size_t m_offset{0};
     };
 
     template<std::endian E>
@@ -140,18 +329,75 @@ namespace kls::essential {
             m_offset += sizeof(T);
         }
 
+        /// <summary>
+        /// Writes all values of the array
+        /// </summary>
         template<class T>
         requires std::is_arithmetic_v<T>
-        [[nodiscard]] bool check(int count = 1) const noexcept {
-            return (m_offset + sizeof(T) * count) <= m_access.size();
+        void put_array(Span<const T> values) noexcept {
+            m_access.put_array(m_offset, values);
+            m_offset += values.size() * sizeof(T);
         }
 
-        auto bytes(int size) noexcept {
+        template<class T>
+        requires std::is_arithmetic_v<T> && (!std::is_const_v<T>)
+        void put_array(Span<T> values) noexcept { put_array(Span<const T>(values)); }
+
+        template<class T>
+        requires std::is_arithmetic_v<T>
+        [[nodiscard]] bool check(size_t count = 1) const noexcept { return reserve(sizeof(T) * count); }
+
+        /// <summary>
+        /// Whether the next bytes fit, one check covers all fields of a record written afterwards
+        /// </summary>
+        [[nodiscard]] bool reserve(size_t bytes) const noexcept { return bytes <= m_access.size() - m_offset; }
+
+        [[nodiscard]] size_t offset() const noexcept { return m_offset; }
+
+        [[nodiscard]] size_t remaining() const noexcept { return m_access.size() - m_offset; }
+
+        auto bytes(size_t size) noexcept {
             auto span = m_access.bytes(m_offset, size);
             return (m_offset += size, span);
         }
+
+        template<size_t N>
+        auto bytes() noexcept {
+            auto span = m_access.template bytes<N>(m_offset);
+            return (m_offset += N, span);
+        }
+
+        /// <summary>
+        /// Writes v as LEB128, needs up to max_varint_size bytes, see varint_size
+        /// </summary>
+        void put_varint(uint64_t v) noexcept {
+            for (; v >= 0x80; v >>= 7) put(uint8_t(v | 0x80));
+            put(uint8_t(v));
+        }
+
+        /// <summary>
+        /// Writes v zigzag encoded as LEB128
+        /// </summary>
+        void put_svarint(int64_t v) noexcept { put_varint(zigzag_encode(v)); }
+
+        void put_varints(Span<const uint32_t> values) noexcept { for (auto v: values) put_varint(v); }
+
+        /// <summary>
+        /// Writes the size of data as LEB128 followed by the bytes, needs varint_size(data.size()) + data.size() bytes
+        /// </summary>
+        void put_prefixed(Span<> data) noexcept {
+            put_varint(data.size());
+            if (data.size()) std::memcpy(bytes(data.size()).data(), data.data(), data.size());
+        }
+
+        void put_string(std::string_view text) noexcept { put_prefixed(Span<>(text.data(), text.size())); }
+
+        /// <summary>
+        /// The bytes written so far, for checksumming or hashing the output incrementally
+        /// </summary>
+        auto written() const noexcept { return m_access.bytes(0, m_offset); }
     private:
         Access<E> m_access;
-        int m_offset{0};
+        size_t m_offset{0};
     };
-}
\ No newline at end of file
+}
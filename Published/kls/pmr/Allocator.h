@@ -50,6 +50,19 @@ namespace kls::pmr {
             return static_cast<T *>(v);
         }
 
+        [[nodiscard]] KLS_ALLOCATE AllocationResult<T *> allocate_at_least(const size_t count) {
+            const auto result = mResource->allocate_at_least(count * sizeof(T), alignof(T));
+            return {static_cast<T *>(result.ptr), result.count / sizeof(T)};
+        }
+
+        [[nodiscard]] bool try_expand(T *const ptr, const size_t count, const size_t new_count) {
+            return mResource->try_expand(ptr, count * sizeof(T), new_count * sizeof(T), alignof(T));
+        }
+
+        [[nodiscard]] bool try_shrink(T *const ptr, const size_t count, const size_t new_count) {
+            return mResource->try_shrink(ptr, count * sizeof(T), new_count * sizeof(T), alignof(T));
+        }
+
         void deallocate(T *const ptr, const size_t count) noexcept {
             // return space for count objects of type T to _Resource
             // No need to verify that size_t can represent the size of T[count].
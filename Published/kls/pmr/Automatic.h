@@ -46,10 +46,24 @@ namespace kls::pmr {
             destroy_many() = default;
             explicit destroy_many(size_t size, MemoryResource *res) noexcept: size(size), allocator(res) {}
             void operator()(Elem *ptr) noexcept {
-                for (size_t i = 0; i < size; ++i) std::destroy_at(ptr + i);
+                std::destroy_n(ptr, size);
                 allocator.deallocate(ptr, size);
             }
         };
+
+        template<class T, class Fn>
+        T *allocate_array(MemoryResource *resource, const size_t size, Fn &&construct) {
+            auto alloc = get_alloc<T>(resource);
+            const auto mem = alloc.allocate(size);
+            try {
+                construct(mem, size);
+            }
+            catch (...) {
+                alloc.deallocate(mem, size);
+                throw;
+            }
+            return mem;
+        }
     }
 
     template<class T>
@@ -69,11 +83,68 @@ namespace kls::pmr {
     template<class T, std::enable_if_t<std::is_array_v<T> && std::extent_v<T> == 0, int> = 0>
     unique_ptr<T> make_unique(MemoryResource *resource, const size_t size) {
         using Elem = std::remove_extent_t<T>;
-        const auto mem = detail::get_alloc<Elem>(resource).allocate(size);
-        for (size_t i = 0; i < size; ++i) std::construct_at(mem + i);
+        const auto mem = detail::allocate_array<Elem>(resource, size, [](Elem *mem, size_t size) {
+            std::uninitialized_value_construct_n(mem, size);
+        });
         return unique_ptr<T>(mem, detail::destroy_many<T>{size, resource});
     }
 
     template<class T, class... Ts, std::enable_if_t<std::extent_v<T> != 0, int> = 0>
     void make_unique(Ts &&...) = delete;
+
+    /// <summary>
+    /// Same as make_unique, but default-initializes the object, leaving trivial types uninitialized
+    /// </summary>
+    template<class T, std::enable_if_t<!std::is_array_v<T>, int> = 0>
+    unique_ptr<T> make_unique_for_overwrite(MemoryResource *resource) {
+        auto alloc = detail::get_alloc<T>(resource);
+        const auto mem = alloc.allocate(1);
+        try {
+            ::new(static_cast<void *>(mem)) T;
+        }
+        catch (...) {
+            alloc.deallocate(mem, 1);
+            throw;
+        }
+        return unique_ptr<T>(mem, detail::destroy_one<T>{resource});
+    }
+
+    /// <summary>
+    /// Same as make_unique, but default-initializes the elements, leaving trivial types uninitialized
+    /// </summary>
+    template<class T, std::enable_if_t<std::is_array_v<T> && std::extent_v<T> == 0, int> = 0>
+    unique_ptr<T> make_unique_for_overwrite(MemoryResource *resource, const size_t size) {
+        using Elem = std::remove_extent_t<T>;
+        const auto mem = detail::allocate_array<Elem>(resource, size, [](Elem *mem, size_t size) {
+            std::uninitialized_default_construct_n(mem, size);
+        });
+        return unique_ptr<T>(mem, detail::destroy_many<T>{size, resource});
+    }
+
+    template<class T, class... Ts, std::enable_if_t<std::extent_v<T> != 0, int> = 0>
+    void make_unique_for_overwrite(Ts &&...) = delete;
+
+    /// <summary>
+    /// Creates a std::shared_ptr with the control block and the object placed in one allocation from resource
+    /// </summary>
+    template<class T, class... Ts>
+    std::shared_ptr<T> make_shared(MemoryResource *resource, Ts &&... args) {
+        using Alloc = PolymorphicAllocator<std::remove_extent_t<T>>;
+        return std::allocate_shared<T>(Alloc(resource), std::forward<Ts>(args)...);
+    }
+
+    /// <summary>
+    /// Same as make_shared, but default-initializes the object, leaving trivial types uninitialized
+    /// </summary>
+    template<class T, class... Ts>
+    std::shared_ptr<T> make_shared_for_overwrite(MemoryResource *resource, Ts &&... args) {
+        using Alloc = PolymorphicAllocator<std::remove_extent_t<T>>;
+        return std::allocate_shared_for_overwrite<T>(Alloc(resource), std::forward<Ts>(args)...);
+    }
+}
+
+namespace kls {
+    // every standard library keeps just the pointer and the deleter, which covers pmr::unique_ptr
+    template<class T, class D>
+    struct is_trivially_relocatable<std::unique_ptr<T, D>> : is_trivially_relocatable<D> {};
 }
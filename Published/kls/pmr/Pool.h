@@ -0,0 +1,163 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <bit>
+#include <algorithm>
+#include "Resource.h"
+
+namespace kls::pmr {
+    namespace detail::pool {
+        // size classes: 16 byte steps up to 256 bytes, then 4 classes per power of two up to 32KiB
+        constexpr size_t linear_classes = 16;
+        constexpr size_t linear_limit = 256;
+        constexpr size_t max_pooled = 32768;
+        constexpr size_t class_count = linear_classes + 4 * (std::bit_width(max_pooled) - std::bit_width(linear_limit));
+
+        [[nodiscard]] constexpr size_t class_of(size_t bytes) noexcept {
+            if (bytes <= linear_limit) return bytes ? (bytes - 1) >> 4 : 0;
+            const auto p = size_t(std::bit_width(bytes - 1) - 1);
+            const auto sub = (bytes - 1 - (size_t(1) << p)) >> (p - 2);
+            return linear_classes + (p - 8) * 4 + sub;
+        }
+
+        [[nodiscard]] constexpr size_t class_size(size_t index) noexcept {
+            if (index < linear_classes) return (index + 1) << 4;
+            const auto p = 8 + (index - linear_classes) / 4, sub = (index - linear_classes) % 4;
+            return (size_t(1) << p) + ((sub + 1) << (p - 2));
+        }
+
+        // amount of nodes moved between a thread cache and the shared depot at once
+        [[nodiscard]] constexpr size_t batch_count(size_t index) noexcept {
+            return std::clamp(size_t(65536) / class_size(index), size_t(2), size_t(64));
+        }
+
+        // size of the runs carved out of the 4MiB blocks for a class
+        [[nodiscard]] constexpr size_t run_size(size_t index) noexcept {
+            return class_size(index) <= 4096 ? size_t(65536) : size_t(262144);
+        }
+
+        [[nodiscard]] constexpr bool pooled(size_t bytes, size_t align) noexcept {
+            return bytes <= max_pooled && align <= alignof(std::max_align_t);
+        }
+
+        static_assert(class_count == 44 && class_size(class_count - 1) == max_pooled);
+        static_assert(class_of(max_pooled) == class_count - 1 && class_of(linear_limit + 1) == linear_classes);
+
+        struct Node { Node *next; };
+
+        /// <summary>
+        /// Takes a list of nodes of the given size class from the shared depot
+        /// </summary>
+        /// <param name="count"> Receives the length of the returned list </param>
+        /// <returns> The list, or nullptr if no more blocks can be rented </returns>
+        [[nodiscard]] Node *depot_take(size_t index, uint32_t &count) noexcept;
+
+        /// <summary>
+        /// Gives a list of exactly batch_count(index) nodes to the shared depot
+        /// </summary>
+        void depot_give_batch(size_t index, Node *list) noexcept;
+
+        /// <summary>
+        /// Gives a null-terminated list of any length to the shared depot
+        /// </summary>
+        void depot_give(size_t index, Node *list) noexcept;
+
+        /// <summary>
+        /// Takes a node of the given size class from the calling thread's cache of pool_resource()
+        /// </summary>
+        /// <returns> The node, or nullptr if no more blocks can be rented </returns>
+        [[nodiscard]] void *allocate(size_t index) noexcept;
+
+        /// <summary>
+        /// Gives a node obtained from allocate() back to the calling thread's cache of pool_resource()
+        /// </summary>
+        void deallocate(void *p, size_t index) noexcept;
+
+        /// <summary>
+        /// Fills every entry of out with a node of the given size class, see allocate()
+        /// </summary>
+        /// <returns> false with all nodes already taken given back if no more blocks can be rented </returns>
+        [[nodiscard]] bool allocate_batch(Span<void *> out, size_t index) noexcept;
+
+        /// <summary>
+        /// Gives every node in ptrs back, see deallocate()
+        /// </summary>
+        void deallocate_batch(Span<void *> ptrs, size_t index) noexcept;
+
+        /// <summary>
+        /// Looks up the size class of a node obtained from allocate()
+        /// </summary>
+        [[nodiscard]] size_t class_of_pointer(const void *p) noexcept;
+    }
+
+    /// <summary>
+    /// Size-class segregated pool that is NOT safe for concurrent use
+    ///
+    /// Requests up to 32KiB are rounded to their size class and served from per-class free lists carved out of
+    /// 4MiB blocks rented from the library's block host. All blocks are returned on destruction, regardless of
+    /// whether the allocations made from this resource have been deallocated.
+    /// Larger or over-aligned requests are forwarded to the upstream resource.
+    /// </summary>
+    class UnsynchronizedPoolResource : public MemoryResource, public AddressSensitive {
+    public:
+        explicit UnsynchronizedPoolResource(MemoryResource *upstream = default_resource()) noexcept;
+        ~UnsynchronizedPoolResource() noexcept override;
+        void release() noexcept;
+        [[nodiscard]] MemoryResource *upstream() const noexcept { return mUpstream; }
+    private:
+        using Node = detail::pool::Node;
+        MemoryResource *mUpstream;
+        Node *mFree[detail::pool::class_count]{};
+        uintptr_t mBlocks{}, mHead{}, mLimit{};
+
+        void *allocate_self(size_t bytes, size_t alignment);
+        void deallocate_self(void *p, size_t bytes, size_t alignment);
+        AllocationResult<void *> allocate_at_least_self(size_t bytes, size_t alignment);
+        bool try_resize_self(void *p, size_t bytes, size_t new_bytes, size_t alignment);
+        void allocate_batch_self(Span<void *> out, size_t bytes, size_t alignment);
+        void deallocate_batch_self(Span<void *> ptrs, size_t bytes, size_t alignment);
+        void *carve(size_t index);
+    };
+
+    /// <summary>
+    /// Obtains the process-wide thread-safe pool resource
+    ///
+    /// Uses the same size classes as UnsynchronizedPoolResource. Each thread keeps a free-list cache per size class
+    /// and exchanges nodes with a shared depot in batches, so the lock is only taken once every batch.
+    /// Larger or over-aligned requests are forwarded to new_delete_resource()
+    /// </summary>
+    /// <returns> The pool resource </returns>
+    MemoryResource *pool_resource() noexcept;
+
+    /// <summary>
+    /// Obtains the process-wide thread-safe pool resource with caches per logical processor
+    ///
+    /// Shares the size classes and the depot with pool_resource(), but indexes the caches by the processor the
+    /// calling thread runs on instead of by thread, so the memory held in caches scales with the core count rather
+    /// than the thread count. Prefer it when running many short-lived or mostly idle threads.
+    /// Larger or over-aligned requests are forwarded to new_delete_resource()
+    /// </summary>
+    /// <returns> The pool resource </returns>
+    MemoryResource *per_processor_pool_resource() noexcept;
+}
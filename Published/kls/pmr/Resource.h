@@ -24,15 +24,29 @@
 
 #include <memory>
 #include <cstddef>
+#include "kls/Span.h"
 #include "kls/Object.h"
 #include "kls/Macros.h"
 
 namespace kls::pmr {
+    /// <summary>
+    /// The result of an allocate_at_least call, count is the amount of units actually usable at ptr
+    /// </summary>
+    template<class Pointer>
+    struct AllocationResult {
+        Pointer ptr;
+        size_t count;
+    };
+
     class MemoryResource : public PmrBase {
     public:
         using FnAllocate = void *(MemoryResource::*)(size_t bytes, size_t alignment);
         using FnDeallocate = void (MemoryResource::*)(void *p, size_t bytes, size_t alignment);
         using FnIsEqual = bool (MemoryResource::*)(const MemoryResource &other) const noexcept;
+        using FnAllocateAtLeast = AllocationResult<void *> (MemoryResource::*)(size_t bytes, size_t alignment);
+        using FnTryResize = bool (MemoryResource::*)(void *p, size_t bytes, size_t new_bytes, size_t alignment);
+        using FnAllocateBatch = void (MemoryResource::*)(Span<void *> out, size_t bytes, size_t alignment);
+        using FnDeallocateBatch = void (MemoryResource::*)(Span<void *> ptrs, size_t bytes, size_t alignment);
 
         [[nodiscard]] KLS_FORCE_INLINE void *allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
             return (*this.*mFnAllocate)(bytes, align);
@@ -42,23 +56,110 @@ namespace kls::pmr {
             return (*this.*mFnDeallocate)(p, bytes, align);
         }
 
+        /// <summary>
+        /// Allocates at least 'bytes' bytes and reports how many bytes are actually usable
+        /// The block may be deallocated with any size between the requested and the reported one
+        /// </summary>
+        [[nodiscard]] KLS_FORCE_INLINE AllocationResult<void *> allocate_at_least(
+                size_t bytes, size_t align = alignof(std::max_align_t)
+        ) {
+            if (mFnAllocateAtLeast) return (*this.*mFnAllocateAtLeast)(bytes, align);
+            return {allocate(bytes, align), bytes};
+        }
+
+        /// <summary>
+        /// Tries to grow the block in place. On success the block must be deallocated with new_bytes
+        /// </summary>
+        [[nodiscard]] KLS_FORCE_INLINE bool try_expand(
+                void *p, size_t bytes, size_t new_bytes, size_t align = alignof(std::max_align_t)
+        ) {
+            if (new_bytes <= bytes) return new_bytes == bytes;
+            if (mFnTryResize) return (*this.*mFnTryResize)(p, bytes, new_bytes, align);
+            return false;
+        }
+
+        /// <summary>
+        /// Tries to shrink the block in place. On success the block must be deallocated with new_bytes
+        /// </summary>
+        [[nodiscard]] KLS_FORCE_INLINE bool try_shrink(
+                void *p, size_t bytes, size_t new_bytes, size_t align = alignof(std::max_align_t)
+        ) {
+            if (new_bytes >= bytes) return new_bytes == bytes;
+            if (mFnTryResize) return (*this.*mFnTryResize)(p, bytes, new_bytes, align);
+            return false;
+        }
+
+        /// <summary>
+        /// Fills every entry of out with a separate block of 'bytes' bytes
+        /// If any allocation fails, the blocks obtained so far are released before the exception propagates
+        /// </summary>
+        KLS_FORCE_INLINE void allocate_batch(Span<void *> out, size_t bytes, size_t align = alignof(std::max_align_t)) {
+            if (mFnAllocateBatch) return (*this.*mFnAllocateBatch)(out, bytes, align);
+            allocate_each(out, bytes, align);
+        }
+
+        /// <summary>
+        /// Releases every block in ptrs, which must all have been allocated with the same size and alignment
+        /// </summary>
+        KLS_FORCE_INLINE void deallocate_batch(
+                Span<void *> ptrs, size_t bytes, size_t align = alignof(std::max_align_t)
+        ) {
+            if (mFnDeallocateBatch) return (*this.*mFnDeallocateBatch)(ptrs, bytes, align);
+            for (const auto p: ptrs) deallocate(p, bytes, align);
+        }
+
         [[nodiscard]] KLS_FORCE_INLINE bool is_equal(const MemoryResource &other) const noexcept {
             if (&other == this) return true;
             if (mFnIsEqual) return (*this.*mFnIsEqual)(other);
             return (typeid(other) == typeid(this));
         }
     protected:
-        MemoryResource(FnAllocate alloc, FnDeallocate dealloc, FnIsEqual equal = nullptr) noexcept
-                : mFnAllocate(alloc), mFnDeallocate(dealloc), mFnIsEqual(equal) {}
+        MemoryResource(
+                FnAllocate alloc, FnDeallocate dealloc, FnIsEqual equal = nullptr,
+                FnAllocateAtLeast alloc_at_least = nullptr, FnTryResize try_resize = nullptr,
+                FnAllocateBatch alloc_batch = nullptr, FnDeallocateBatch dealloc_batch = nullptr
+        ) noexcept: mFnAllocate(alloc), mFnDeallocate(dealloc), mFnIsEqual(equal),
+                    mFnAllocateAtLeast(alloc_at_least), mFnTryResize(try_resize),
+                    mFnAllocateBatch(alloc_batch), mFnDeallocateBatch(dealloc_batch) {}
+
+        void allocate_each(Span<void *> out, size_t bytes, size_t align) {
+            size_t i = 0;
+            try {
+                for (; i < out.size(); ++i) out.data()[i] = allocate(bytes, align);
+            }
+            catch (...) {
+                while (i) deallocate(out.data()[--i], bytes, align);
+                throw;
+            }
+        }
     private:
         FnAllocate mFnAllocate;
         FnDeallocate mFnDeallocate;
         FnIsEqual mFnIsEqual;
+        FnAllocateAtLeast mFnAllocateAtLeast;
+        FnTryResize mFnTryResize;
+        FnAllocateBatch mFnAllocateBatch;
+        FnDeallocateBatch mFnDeallocateBatch;
     };
 
     [[nodiscard]] inline bool operator==(const MemoryResource &l, const MemoryResource &r) noexcept {
         return l.is_equal(r);
     }
 
+    /// <summary>
+    /// Obtains the resource that forwards to the global operator new and delete
+    /// </summary>
+    MemoryResource *new_delete_resource() noexcept;
+
+    /// <summary>
+    /// Obtains the current default resource, which is new_delete_resource() unless replaced
+    /// </summary>
     MemoryResource *default_resource() noexcept;
+
+    /// <summary>
+    /// Atomically replaces the default resource. Allocators constructed before the call keep their resource
+    /// </summary>
+    /// <param name="resource"> The new default resource, nullptr restores new_delete_resource() </param>
+    /// <returns> The previous default resource </returns>
+    MemoryResource *set_default_resource(MemoryResource *resource) noexcept;
 }
\ No newline at end of file
@@ -0,0 +1,96 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <new>
+#include <concepts>
+#include <type_traits>
+#include "Resource.h"
+#include "Allocator.h"
+
+namespace kls::pmr {
+    /// <summary>
+    /// A type that provides memory through static member functions, so that the call can be resolved at compile time
+    /// </summary>
+    template<class R>
+    concept StaticResource = requires(void *p, size_t bytes, size_t align) {
+        { R::allocate(bytes, align) } -> std::same_as<void *>;
+        { R::deallocate(p, bytes, align) } noexcept;
+    };
+
+    /// <summary>
+    /// Compile-time counterpart of PolymorphicAllocator
+    ///
+    /// The resource is part of the type, so the allocator is stateless, always compares equal and the allocation
+    /// calls can be inlined instead of going through the MemoryResource function table
+    /// </summary>
+    template<class T, StaticResource R>
+    class StaticAllocator {
+    public:
+        using value_type = T;
+        using resource_type = R;
+        using is_always_equal = std::true_type;
+
+        template<class U>
+        struct rebind { using other = StaticAllocator<U, R>; };
+
+        constexpr StaticAllocator() noexcept = default;
+
+        template<class U>
+        constexpr StaticAllocator(const StaticAllocator<U, R> &) noexcept {} // NOLINT
+
+        [[nodiscard]] KLS_ALLOCATE T *allocate(const size_t count) {
+            return static_cast<T *>(R::allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *const ptr, const size_t count) noexcept {
+            R::deallocate(ptr, count * sizeof(T), alignof(T));
+        }
+
+        template<class U>
+        [[nodiscard]] constexpr bool operator==(const StaticAllocator<U, R> &) const noexcept { return true; }
+    };
+
+    /// <summary>
+    /// Static resource backed directly by the global operator new and delete
+    /// </summary>
+    struct NewDeleteStaticResource {
+        [[nodiscard]] KLS_FORCE_INLINE static void *allocate(size_t bytes, size_t align) {
+            if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) return ::operator new(bytes, std::align_val_t{align});
+            return ::operator new(bytes);
+        }
+
+        KLS_FORCE_INLINE static void deallocate(void *p, size_t bytes, size_t align) noexcept {
+            if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) return ::operator delete(p, bytes, std::align_val_t{align});
+            ::operator delete(p, bytes);
+        }
+    };
+
+    template<class T>
+    using new_delete_allocator = StaticAllocator<T, NewDeleteStaticResource>;
+
+    // the default resource can be replaced at runtime, so it is captured when the allocator is constructed and memory
+    // always goes back to the resource it came from
+    template<class T>
+    using default_allocator = PolymorphicAllocator<T>;
+}
@@ -0,0 +1,108 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include "Resource.h"
+
+namespace kls::pmr {
+    struct ResourceStats {
+        // bucket i counts requests of at most (1 << i) bytes, the last bucket counts everything larger
+        static constexpr size_t size_buckets = 24;
+        // bucket i counts requests aligned to (1 << i) bytes, the last bucket counts everything larger
+        static constexpr size_t align_buckets = 13;
+
+        uint64_t allocations{};
+        uint64_t deallocations{};
+        int64_t live_bytes{};
+        int64_t peak_bytes{};
+        uint64_t sizes[size_buckets]{};
+        uint64_t alignments[align_buckets]{};
+    };
+
+    /// <summary>
+    /// Adaptor that forwards all requests to an upstream resource and records statistics about them
+    ///
+    /// The counters are sharded by thread. The first 32 threads to use any StatsResource own a shard each and update
+    /// it with relaxed loads and stores, all further threads share one shard with relaxed read-modify-writes.
+    /// Live bytes are kept per shard as well, so they are exact. Each shard publishes its live bytes to a shared total
+    /// once they moved by flush_bytes, and the peak is taken from that total and from every stats() call, so it may
+    /// miss a short spike of up to flush_bytes per thread
+    ///
+    /// Every instance registers itself under its name for visit_stats_resources() until destroyed
+    /// </summary>
+    class StatsResource : public MemoryResource, public AddressSensitive {
+    public:
+        explicit StatsResource(std::string name, MemoryResource *upstream = default_resource());
+        ~StatsResource() noexcept override;
+        [[nodiscard]] ResourceStats stats() const noexcept;
+        [[nodiscard]] std::string_view name() const noexcept { return mName; }
+        [[nodiscard]] MemoryResource *upstream() const noexcept { return mUpstream; }
+    private:
+        static constexpr size_t exclusive_shards = 32;
+        static constexpr int64_t flush_bytes = 64 << 10;
+
+        struct alignas(64) Shard {
+            std::atomic<uint64_t> deallocations{};
+            std::atomic<int64_t> live{};
+            // live bytes not yet published to the shared total
+            std::atomic<int64_t> pending{};
+            std::atomic<uint64_t> sizes[ResourceStats::size_buckets]{};
+            std::atomic<uint64_t> alignments[ResourceStats::align_buckets]{};
+        };
+
+        std::string mName;
+        MemoryResource *mUpstream;
+        StatsResource *mPrev{}, *mNext{};
+        alignas(64) std::atomic<int64_t> mPublished{};
+        mutable std::atomic<int64_t> mPeak{};
+        Shard mShards[exclusive_shards + 1];
+
+        friend struct StatsRegistry;
+        void *allocate_self(size_t bytes, size_t alignment);
+        void deallocate_self(void *p, size_t bytes, size_t alignment);
+        AllocationResult<void *> allocate_at_least_self(size_t bytes, size_t alignment);
+        bool try_resize_self(void *p, size_t bytes, size_t new_bytes, size_t alignment);
+        void allocate_batch_self(Span<void *> out, size_t bytes, size_t alignment);
+        void deallocate_batch_self(Span<void *> ptrs, size_t bytes, size_t alignment);
+        void record_allocation(size_t bytes, size_t alignment, size_t count = 1) noexcept;
+        void record_deallocation(size_t bytes, size_t count = 1) noexcept;
+        static size_t shard_index() noexcept;
+        void record(Shard &shard, int64_t delta, bool exclusive) noexcept;
+        void raise_peak(int64_t live) const noexcept;
+    };
+
+    /// <summary>
+    /// Calls fn on every StatsResource that is currently alive, while holding the registry lock
+    /// </summary>
+    void visit_stats_resources(const std::function<void(const StatsResource &)> &fn);
+
+    /// <summary>
+    /// Formats the statistics of every StatsResource that is currently alive as human-readable text
+    /// </summary>
+    std::string dump_stats_resources();
+}
@@ -0,0 +1,288 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+#include "Allocator.h"
+#include "kls/Span.h"
+
+namespace kls::pmr {
+    /// <summary>
+    /// Contiguous growable array that grows in place when the resource can expand the block, and moves trivially
+    /// relocatable elements with memmove when it cannot
+    /// </summary>
+    /// <typeparam name="T"> The type of the elements </typeparam>
+    template<class T>
+    class Vector {
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using iterator = T *;
+        using const_iterator = const T *;
+        using allocator_type = PolymorphicAllocator<T>;
+
+        Vector() noexcept = default;
+
+        explicit Vector(allocator_type alloc) noexcept: mAlloc(alloc) {}
+
+        Vector(std::initializer_list<T> init, allocator_type alloc = {}): mAlloc(alloc) {
+            assign(init.begin(), init.end());
+        }
+
+        Vector(const Vector &o): Vector(o, o.mAlloc) {}
+
+        Vector(const Vector &o, allocator_type alloc): mAlloc(alloc) { assign(o.begin(), o.end()); }
+
+        Vector(Vector &&o) noexcept:
+                mData(std::exchange(o.mData, nullptr)), mSize(std::exchange(o.mSize, 0)),
+                mCapacity(std::exchange(o.mCapacity, 0)), mAlloc(o.mAlloc) {}
+
+        Vector &operator=(const Vector &o) {
+            if (&o != this) {
+                clear();
+                assign(o.begin(), o.end());
+            }
+            return *this;
+        }
+
+        // the allocator stays, the storage is only taken over if it comes from an equal resource
+        Vector &operator=(Vector &&o) {
+            if (&o == this) return *this;
+            if (mAlloc == o.mAlloc) {
+                release();
+                mData = std::exchange(o.mData, nullptr);
+                mSize = std::exchange(o.mSize, 0);
+                mCapacity = std::exchange(o.mCapacity, 0);
+            }
+            else {
+                clear();
+                assign(std::make_move_iterator(o.begin()), std::make_move_iterator(o.end()));
+                o.clear();
+            }
+            return *this;
+        }
+
+        ~Vector() noexcept { release(); }
+
+        [[nodiscard]] size_t size() const noexcept { return mSize; }
+
+        [[nodiscard]] size_t capacity() const noexcept { return mCapacity; }
+
+        [[nodiscard]] bool empty() const noexcept { return mSize == 0; }
+
+        [[nodiscard]] allocator_type get_allocator() const noexcept { return mAlloc; }
+
+        T *data() noexcept { return mData; }
+
+        const T *data() const noexcept { return mData; }
+
+        T *begin() noexcept { return mData; }
+
+        T *end() noexcept { return mData + mSize; }
+
+        const T *begin() const noexcept { return mData; }
+
+        const T *end() const noexcept { return mData + mSize; }
+
+        T &operator[](size_t index) noexcept { return mData[index]; }
+
+        const T &operator[](size_t index) const noexcept { return mData[index]; }
+
+        T &front() noexcept { return mData[0]; }
+
+        const T &front() const noexcept { return mData[0]; }
+
+        T &back() noexcept { return mData[mSize - 1]; }
+
+        const T &back() const noexcept { return mData[mSize - 1]; }
+
+        void reserve(size_t count) { if (count > mCapacity && !expand(count)) reallocate(count); }
+
+        /// <summary>
+        /// Gives back unused capacity, in place if the resource supports it
+        /// </summary>
+        void shrink_to_fit() {
+            if (mSize == mCapacity) return;
+            if (!mSize) return release();
+            if (mAlloc.try_shrink(mData, mCapacity, mSize)) mCapacity = mSize; else reallocate(mSize, true);
+        }
+
+        template<class... Ts>
+        T &emplace_back(Ts &&... args) {
+            if (mSize == mCapacity && !expand(grown(mSize + 1))) {
+                // the arguments may refer to current elements, construct before they are relocated
+                const auto result = mAlloc.allocate_at_least(grown(mSize + 1));
+                try {
+                    std::construct_at(result.ptr + mSize, std::forward<Ts>(args)...);
+                }
+                catch (...) {
+                    mAlloc.deallocate(result.ptr, result.count);
+                    throw;
+                }
+                adopt(result, 1);
+            }
+            else std::construct_at(mData + mSize, std::forward<Ts>(args)...);
+            return mData[mSize++];
+        }
+
+        void push_back(const T &value) { emplace_back(value); }
+
+        void push_back(T &&value) { emplace_back(std::move(value)); }
+
+        void pop_back() noexcept { std::destroy_at(mData + --mSize); }
+
+        template<class... Ts>
+        T *emplace(const T *pos, Ts &&... args) {
+            const auto index = size_t(pos - mData);
+            if constexpr (is_trivially_relocatable_v<T>) {
+                // build the value aside, open a gap by shifting the bytes of the tail and drop the value in
+                alignas(T) unsigned char buffer[sizeof(T)];
+                const auto value = std::construct_at(reinterpret_cast<T *>(buffer), std::forward<Ts>(args)...);
+                try {
+                    if (mSize == mCapacity) reserve(grown(mSize + 1));
+                }
+                catch (...) {
+                    std::destroy_at(value);
+                    throw;
+                }
+                const auto slot = mData + index;
+                std::memmove(static_cast<void *>(slot + 1), slot, (mSize - index) * sizeof(T));
+                std::memcpy(static_cast<void *>(slot), buffer, sizeof(T));
+                ++mSize;
+            }
+            else {
+                emplace_back(std::forward<Ts>(args)...);
+                std::rotate(mData + index, mData + mSize - 1, mData + mSize);
+            }
+            return mData + index;
+        }
+
+        T *insert(const T *pos, const T &value) { return emplace(pos, value); }
+
+        T *insert(const T *pos, T &&value) { return emplace(pos, std::move(value)); }
+
+        T *erase(const T *pos) { return erase(pos, pos + 1); }
+
+        T *erase(const T *first, const T *last) {
+            const auto from = mData + (first - mData), to = mData + (last - mData);
+            if (from == to) return from;
+            if constexpr (is_trivially_relocatable_v<T>) {
+                std::destroy(from, to);
+                std::memmove(static_cast<void *>(from), to, (end() - to) * sizeof(T));
+            }
+            else std::destroy(std::move(to, end(), from), end());
+            mSize -= size_t(to - from);
+            return from;
+        }
+
+        void resize(size_t count) { resize_with(count, [](T *p) { std::construct_at(p); }); }
+
+        void resize(size_t count, const T &value) {
+            if (count > mSize && count > mCapacity) {
+                // the value may be one of the elements, keep a copy across the reallocation
+                const T copy = value;
+                return resize_with(count, [&copy](T *p) { std::construct_at(p, copy); });
+            }
+            resize_with(count, [&value](T *p) { std::construct_at(p, value); });
+        }
+
+        void clear() noexcept {
+            std::destroy_n(mData, mSize);
+            mSize = 0;
+        }
+    private:
+        T *mData{};
+        size_t mSize{};
+        size_t mCapacity{};
+        allocator_type mAlloc{};
+
+        [[nodiscard]] size_t grown(size_t needed) const noexcept { return std::max(needed, mCapacity * 2); }
+
+        bool expand(size_t count) {
+            if (!mData || !mAlloc.try_expand(mData, mCapacity, count)) return false;
+            mCapacity = count;
+            return true;
+        }
+
+        void reallocate(size_t count, bool exact = false) {
+            if (exact) {
+                const auto ptr = mAlloc.allocate(count);
+                return adopt({ptr, count}, 0);
+            }
+            adopt(mAlloc.allocate_at_least(count), 0);
+        }
+
+        // moves the elements into the new block, which already holds `extra` constructed elements past them
+        void adopt(AllocationResult<T *> block, size_t extra) {
+            if constexpr (is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>) {
+                relocate(Span<T>(mData, mSize), Span<T>(block.ptr, mSize));
+            }
+            else {
+                try {
+                    std::uninitialized_copy_n(mData, mSize, block.ptr);
+                }
+                catch (...) {
+                    std::destroy_n(block.ptr + mSize, extra);
+                    mAlloc.deallocate(block.ptr, block.count);
+                    throw;
+                }
+                std::destroy_n(mData, mSize);
+            }
+            if (mData) mAlloc.deallocate(mData, mCapacity);
+            mData = block.ptr;
+            mCapacity = block.count;
+        }
+
+        template<class Fn>
+        void resize_with(size_t count, Fn &&construct) {
+            if (count <= mSize) {
+                std::destroy(mData + count, mData + mSize);
+                mSize = count;
+                return;
+            }
+            reserve(count);
+            for (; mSize < count; ++mSize) construct(mData + mSize);
+        }
+
+        template<class It>
+        void assign(It first, It last) {
+            reserve(size_t(std::distance(first, last)));
+            for (; first != last; ++first) std::construct_at(mData + mSize++, *first);
+        }
+
+        void release() noexcept {
+            clear();
+            if (mData) mAlloc.deallocate(mData, mCapacity);
+            mData = nullptr;
+            mCapacity = 0;
+        }
+    };
+}
+
+namespace kls {
+    template<class T>
+    struct is_trivially_relocatable<pmr::Vector<T>> : std::true_type {};
+}
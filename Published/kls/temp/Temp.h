@@ -23,11 +23,32 @@
 #pragma once
 
 #include <cstdint>
+#include "kls/pmr/Static.h"
 #include "kls/pmr/Automatic.h"
 
 namespace kls::temp {
     pmr::MemoryResource *resource() noexcept;
 
+    [[nodiscard]] KLS_ALLOCATE void *allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+    void deallocate(void *p, size_t bytes, size_t align = alignof(std::max_align_t)) noexcept;
+
+    /// <summary>
+    /// Static resource that calls into the temp allocator directly instead of through resource()
+    /// </summary>
+    struct StaticResource {
+        [[nodiscard]] KLS_FORCE_INLINE static void *allocate(size_t bytes, size_t align) {
+            return temp::allocate(bytes, align);
+        }
+
+        KLS_FORCE_INLINE static void deallocate(void *p, size_t bytes, size_t align) noexcept {
+            temp::deallocate(p, bytes, align);
+        }
+    };
+
+    template<class T>
+    using static_allocator = pmr::StaticAllocator<T, StaticResource>;
+
     template<class T>
     struct allocator: pmr::PolymorphicAllocator<T> {
         allocator() noexcept: pmr::PolymorphicAllocator<T>(resource()) {}
@@ -47,4 +68,19 @@ namespace kls::temp {
 
     template<class T, class... Ts, std::enable_if_t<std::extent_v<T> != 0, int> = 0>
     void make_unique(Ts &&...) = delete;
+
+    template<class T, class... Ts>
+    decltype(auto) make_unique_for_overwrite(Ts &&... args) {
+        return pmr::make_unique_for_overwrite<T>(resource(), std::forward<Ts>(args)...);
+    }
+
+    template<class T, class... Ts>
+    decltype(auto) make_shared(Ts &&... args) {
+        return pmr::make_shared<T>(resource(), std::forward<Ts>(args)...);
+    }
+
+    template<class T, class... Ts>
+    decltype(auto) make_shared_for_overwrite(Ts &&... args) {
+        return pmr::make_shared_for_overwrite<T>(resource(), std::forward<Ts>(args)...);
+    }
 }
@@ -0,0 +1,51 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <exception>
+
+// every test is a plain executable, failed checks are reported and turn into a non-zero exit code
+namespace kls::test {
+    inline int failures = 0;
+
+    inline void check(bool ok, const char *expression, const char *file, int line) noexcept {
+        if (ok) return;
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        ++failures;
+    }
+
+    template<class Fn>
+    int run(Fn &&body) noexcept {
+        try {
+            body();
+        }
+        catch (const std::exception &e) {
+            std::fprintf(stderr, "uncaught exception: %s\n", e.what());
+            ++failures;
+        }
+        return failures ? 1 : 0;
+    }
+}
+
+#define KLS_CHECK(...) ::kls::test::check(bool(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
@@ -0,0 +1,154 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "Check.h"
+#include "kls/Handle.h"
+
+using namespace kls;
+
+namespace {
+    std::atomic_int g_closed{0};
+    std::atomic_int g_seen{-1};
+
+    struct Close {
+        void operator()(int &value) const noexcept {
+            g_seen.store(value);
+            g_closed.fetch_add(1);
+        }
+    };
+
+    template<class Counting>
+    struct IntHandle : Handle<int, Counting> {
+        using Handle<int, Counting>::Handle;
+
+        void set(int v) noexcept { this->value() = v; }
+    };
+
+    // duplicates and plain copies share one close, the destructor sees the value of the closing handle
+    template<class Counting>
+    void closes_once() {
+        using H = IntHandle<Counting>;
+        const auto before = g_closed.load();
+        {
+            SafeHandle<H> a(H(Close{}, 5));
+            auto b = a;
+            auto c = b;
+            SafeHandle<H> d(H(Close{}, 6));
+            d = c;
+        }
+        KLS_CHECK(g_closed.load() - before == 2);
+        {
+            H a(Close{}, 1);
+            H alias = a;
+            auto b = HandleAccess::duplicate(a);
+            b.set(42);
+            HandleAccess::close(alias);
+            KLS_CHECK(g_closed.load() - before == 2);
+            HandleAccess::close(b);
+            KLS_CHECK(g_closed.load() - before == 3 && g_seen.load() == 42);
+        }
+        int captured = 0;
+        {
+            SafeHandle<H> a(H([&captured](int &v) noexcept { captured = v; }, 9));
+            auto b = a;
+        }
+        KLS_CHECK(captured == 9);
+    }
+
+    // threads copying a handle that was never duplicated race to create its control block
+    void concurrent_promotion() {
+        using H = IntHandle<AtomicHandleCount>;
+        const auto before = g_closed.load();
+        for (int round = 0; round < 100; ++round) {
+            SafeHandle<H> a(H(Close{}, 1));
+            std::vector<SafeHandle<H>> first, second;
+            std::thread t1([&] { for (int i = 0; i < 50; ++i) first.push_back(a); });
+            std::thread t2([&] { for (int i = 0; i < 50; ++i) second.push_back(a); });
+            t1.join();
+            t2.join();
+        }
+        KLS_CHECK(g_closed.load() - before == 100);
+    }
+
+    // other threads release the references the owner handed them, the owner merges them on its next release
+    void biased_across_threads() {
+        using H = IntHandle<BiasedHandleCount>;
+        const auto before = g_closed.load();
+        for (int round = 0; round < 50; ++round) {
+            {
+                SafeHandle<H> a(H(Close{}, 1));
+                std::vector<std::thread> threads;
+                for (int i = 0; i < 4; ++i) {
+                    threads.emplace_back([c = a]() mutable { for (int k = 0; k < 100; ++k) auto d = c; });
+                }
+                for (auto &t: threads) t.join();
+            }
+            SafeHandle<H> z(H(Close{}, 1));
+            auto y = z;
+        }
+        KLS_CHECK(g_closed.load() - before == 100);
+        // the owner exits while another thread still holds a reference
+        SafeHandle<H> *held = nullptr;
+        std::thread([&] {
+            SafeHandle<H> a(H(Close{}, 1));
+            held = new SafeHandle<H>(a);
+        }).join();
+        KLS_CHECK(g_closed.load() - before == 100);
+        std::thread([&] { delete held; }).join();
+        KLS_CHECK(g_closed.load() - before == 101);
+        // the owner drops its reference after a foreign release, the merge happens when the owner exits
+        std::thread([] {
+            SafeHandle<H> a(H(Close{}, 1));
+            auto c = a;
+            std::thread([c] {}).join();
+        }).join();
+        KLS_CHECK(g_closed.load() - before == 102);
+    }
+
+    void retired_closes_on_reclaim() {
+        using H = IntHandle<AtomicHandleCount>;
+        const auto before = g_closed.load();
+        {
+            EpochDomain domain{};
+            H a(retired(Close{}, domain), 1);
+            auto b = HandleAccess::duplicate(a);
+            b.set(44);
+            HandleAccess::close(a);
+            HandleAccess::close(b);
+        }
+        KLS_CHECK(g_closed.load() - before == 1 && g_seen.load() == 44);
+    }
+}
+
+int main() {
+    return test::run([] {
+        closes_once<AtomicHandleCount>();
+        closes_once<LocalHandleCount>();
+        closes_once<BiasedHandleCount>();
+        concurrent_promotion();
+        biased_across_threads();
+        retired_closes_on_reclaim();
+    });
+}
@@ -0,0 +1,131 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <random>
+#include <algorithm>
+#include <string_view>
+#include <vector>
+#include "Check.h"
+#include "kls/Hash.h"
+#include "kls/Simd.h"
+
+using namespace kls;
+
+namespace {
+    constexpr simd::Level levels[] = {simd::Level::Scalar, simd::Level::SSE2, simd::Level::AVX2, simd::Level::AVX512};
+
+    Span<> bytes(const void *data, size_t size) noexcept { return {data, size}; }
+
+    std::vector<unsigned char> random_bytes(size_t size) {
+        std::mt19937_64 random{size};
+        std::vector<unsigned char> data(size);
+        for (auto &x: data) x = static_cast<unsigned char>(random());
+        return data;
+    }
+
+    // the standard check value, at every level and however the input is split
+    void crc32c_check_value() {
+        constexpr std::string_view check = "123456789";
+        for (const auto level: levels) {
+            if (simd::set_level(level) != level) continue;
+            KLS_CHECK(hash::crc32c(bytes(check.data(), check.size())) == 0xe3069283u);
+            KLS_CHECK(hash::crc32c(bytes(nullptr, 0)) == 0);
+            for (size_t split = 0; split <= check.size(); ++split) {
+                hash::Crc32c crc{};
+                crc.update(bytes(check.data(), split));
+                crc.update(bytes(check.data() + split, check.size() - split));
+                KLS_CHECK(crc.value() == 0xe3069283u);
+            }
+        }
+        simd::set_level(simd::supported_level());
+    }
+
+    // the accelerated and the table driven checksum agree on every length and misalignment
+    void crc32c_levels_agree() {
+        const auto data = random_bytes(1100);
+        for (size_t offset = 0; offset < 8; ++offset) {
+            for (size_t size = 0; offset + size <= data.size(); size += 1 + size / 8) {
+                simd::set_level(simd::Level::Scalar);
+                const auto expected = hash::crc32c(bytes(data.data() + offset, size), 0x12345678);
+                simd::set_level(simd::supported_level());
+                KLS_CHECK(hash::crc32c(bytes(data.data() + offset, size), 0x12345678) == expected);
+            }
+        }
+    }
+
+    // the digest of Hasher64 equals the one-shot hash for every length around the short, stripe and buffer
+    // boundaries and for every chunking of the input
+    void hasher_matches_one_shot() {
+        const auto data = random_bytes(3 * hash::Hasher64::buffer + 100);
+        for (size_t size = 0; size <= data.size(); size += size < 300 ? 1 : 7) {
+            const auto expected = hash::hash64(bytes(data.data(), size), 42);
+            for (const size_t chunk: {size_t(1), size_t(3), size_t(63), size_t(64), size_t(65), size_t(256), size}) {
+                hash::Hasher64 hasher{42};
+                for (size_t at = 0; at < size; at += chunk)
+                    hasher.update(bytes(data.data() + at, std::min(chunk, size - at)));
+                KLS_CHECK(hasher.digest() == expected);
+            }
+        }
+        hash::Hasher64 hasher{7};
+        hasher.update(bytes(data.data(), data.size()));
+        hasher.reset(42);
+        hasher.update(bytes(data.data(), 500));
+        KLS_CHECK(hasher.digest() == hash::hash64(bytes(data.data(), 500), 42));
+    }
+
+    void hash64_depends_on_input() {
+        auto data = random_bytes(1000);
+        for (const size_t size: {size_t(0), size_t(8), size_t(100), size_t(1000)}) {
+            const auto base = hash::hash64(bytes(data.data(), size));
+            KLS_CHECK(hash::hash64(bytes(data.data(), size), 1) != base);
+            if (size) {
+                data[size / 2] ^= 1;
+                KLS_CHECK(hash::hash64(bytes(data.data(), size)) != base);
+                data[size / 2] ^= 1;
+            }
+        }
+    }
+
+    // hash64 does not depend on the vector level it runs at
+    void hash64_levels_agree() {
+        const auto data = random_bytes(5000);
+        for (size_t size = 0; size <= data.size(); size += 1 + size / 4) {
+            simd::set_level(simd::Level::Scalar);
+            const auto expected = hash::hash64(bytes(data.data(), size), 9);
+            for (const auto level: levels) {
+                if (simd::set_level(level) != level) continue;
+                KLS_CHECK(hash::hash64(bytes(data.data(), size), 9) == expected);
+            }
+        }
+        simd::set_level(simd::supported_level());
+    }
+}
+
+int main() {
+    return test::run([] {
+        crc32c_check_value();
+        crc32c_levels_agree();
+        hasher_matches_one_shot();
+        hash64_depends_on_input();
+        hash64_levels_agree();
+    });
+}
@@ -0,0 +1,62 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "Check.h"
+#include "kls/MdSpan.h"
+
+using namespace kls;
+
+namespace {
+    // the visit order must be the storage order of operator() over exactly the cells inside the extents
+    template<class E>
+    bool morton_visit_matches(E extents) {
+        using Cell = std::pair<typename E::Index, size_t>;
+        const LayoutMorton::Mapping<E> mapping(extents);
+        std::vector<Cell> visited, expected;
+        mapping.visit([&](const typename E::Index &idx, size_t offset) { visited.emplace_back(idx, offset); });
+        typename E::Index idx{};
+        const auto enumerate = [&](auto &self, size_t r) -> void {
+            if (r == E::rank()) return expected.emplace_back(idx, mapping(idx)), void();
+            for (idx[r] = 0; idx[r] < extents.extent(r); ++idx[r]) self(self, r + 1);
+        };
+        enumerate(enumerate, 0);
+        std::sort(expected.begin(), expected.end(), [](const Cell &l, const Cell &r) { return l.second < r.second; });
+        return visited == expected;
+    }
+}
+
+int main() {
+    return test::run([] {
+        constexpr auto d = dynamic_extent;
+        KLS_CHECK(morton_visit_matches(Extents<d>(7)));
+        KLS_CHECK(morton_visit_matches(Extents<d, d>(1, 1)));
+        KLS_CHECK(morton_visit_matches(Extents<d, d>(5, 13)));
+        KLS_CHECK(morton_visit_matches(Extents<d, d>(16, 16)));
+        KLS_CHECK(morton_visit_matches(Extents<d, d>(0, 4)));
+        KLS_CHECK(morton_visit_matches(Extents<d, d, d>(3, 9, 6)));
+        KLS_CHECK(morton_visit_matches(Extents<4, 4, 4>()));
+        KLS_CHECK(morton_visit_matches(Extents<d, d, d, d>(2, 3, 5, 4)));
+    });
+}
@@ -0,0 +1,91 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <set>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <numeric>
+#include <stdexcept>
+#include "Check.h"
+#include "kls/Parallel.h"
+
+using namespace kls;
+
+namespace {
+    void algorithms_match_serial() {
+        std::vector<uint32_t> source(3 << 20), target(source.size());
+        std::iota(source.begin(), source.end(), 0u);
+        KLS_CHECK(parallel::copy(Span<uint32_t>(source), Span<uint32_t>(target)) && target == source);
+        parallel::transform(Span<uint32_t>(source), Span<uint32_t>(target), [](uint32_t x) { return x * 3; });
+        parallel::for_each(Span<uint32_t>(target), [](uint32_t &x) { x += 1; });
+        KLS_CHECK(target[12345] == 12345 * 3 + 1 && target.back() == uint32_t(source.back() * 3 + 1));
+        const auto sum = parallel::reduce(Span<uint32_t>(source), uint64_t(7), [](uint64_t l, uint64_t r) { return l + r; });
+        KLS_CHECK(sum == uint64_t(source.size()) * (source.size() - 1) / 2 + 7);
+        KLS_CHECK(!parallel::copy(Span<uint32_t>(source), Span<uint32_t>(target.data(), 3)));
+    }
+
+    void exceptions_reach_the_caller() {
+        bool caught = false;
+        try {
+            parallel::detail::run(32, [](size_t chunk) { if (chunk == 17) throw std::runtime_error("chunk"); });
+        }
+        catch (const std::runtime_error &) {
+            caught = true;
+        }
+        KLS_CHECK(caught);
+    }
+
+    // two callers at once both get every chunk done exactly once, and both are helped by pool threads
+    void concurrent_callers_share_the_pool() {
+        struct record {
+            std::mutex lock;
+            std::vector<int> runs = std::vector<int>(64);
+            std::set<std::thread::id> threads;
+        } records[2];
+        std::vector<std::thread> callers;
+        for (auto &r: records) {
+            callers.emplace_back([&r] {
+                parallel::detail::run(r.runs.size(), [&r](size_t chunk) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    const std::lock_guard lock(r.lock);
+                    ++r.runs[chunk];
+                    r.threads.insert(std::this_thread::get_id());
+                });
+            });
+        }
+        for (auto &caller: callers) caller.join();
+        for (auto &r: records) {
+            KLS_CHECK(std::all_of(r.runs.begin(), r.runs.end(), [](int n) { return n == 1; }));
+            KLS_CHECK(r.threads.size() > 1);
+        }
+    }
+}
+
+int main() {
+    return test::run([] {
+        parallel::set_concurrency(4);
+        algorithms_match_serial();
+        exceptions_reach_the_caller();
+        concurrent_callers_share_the_pool();
+    });
+}
@@ -0,0 +1,102 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include "Check.h"
+#include "kls/pmr/Pool.h"
+
+using namespace kls::pmr;
+
+namespace {
+    struct range {
+        uintptr_t begin, end;
+    };
+
+    bool disjoint(std::vector<range> ranges) {
+        std::sort(ranges.begin(), ranges.end(), [](range l, range r) { return l.begin < r.begin; });
+        for (size_t i = 1; i < ranges.size(); ++i) if (ranges[i - 1].end > ranges[i].begin) return false;
+        return true;
+    }
+
+    // takes more than a full batch of every large class, then small nodes from the runs that follow
+    void large_classes_do_not_overlap(MemoryResource *resource) {
+        using namespace detail::pool;
+        struct allocation {
+            void *p;
+            size_t size;
+        };
+        std::vector<allocation> live;
+        for (auto index = class_of(1024); index < class_count; ++index) {
+            const auto size = class_size(index);
+            for (size_t i = 0; i < 2 * batch_count(index) + 1; ++i) live.push_back({resource->allocate(size), size});
+            live.push_back({resource->allocate(16), 16});
+        }
+        std::vector<range> ranges;
+        for (const auto &a: live) ranges.push_back({uintptr_t(a.p), uintptr_t(a.p) + a.size});
+        KLS_CHECK(disjoint(ranges));
+        for (size_t i = 0; i < live.size(); ++i) std::memset(live[i].p, int(i & 0xFF), live[i].size);
+        for (size_t i = 0; i < live.size(); ++i) {
+            const auto bytes = static_cast<const unsigned char *>(live[i].p);
+            KLS_CHECK(bytes[0] == (i & 0xFF) && bytes[live[i].size - 1] == (i & 0xFF));
+        }
+        for (const auto &a: live) resource->deallocate(a.p, a.size);
+    }
+
+    void nodes_are_reused(MemoryResource *resource) {
+        const auto p = resource->allocate(48);
+        resource->deallocate(p, 48);
+        const auto q = resource->allocate(40);
+        KLS_CHECK(p == q);
+        resource->deallocate(q, 40);
+    }
+
+    void batches_round_trip(MemoryResource *resource) {
+        std::vector<void *> nodes(1000);
+        resource->allocate_batch(kls::Span<void *>(nodes), 24);
+        std::vector<range> ranges;
+        for (const auto p: nodes) ranges.push_back({uintptr_t(p), uintptr_t(p) + 24});
+        KLS_CHECK(disjoint(ranges));
+        resource->deallocate_batch(kls::Span<void *>(nodes), 24);
+    }
+
+    void unsynchronized_resource() {
+        UnsynchronizedPoolResource resource{};
+        large_classes_do_not_overlap(&resource);
+        nodes_are_reused(&resource);
+        batches_round_trip(&resource);
+        const auto p = resource.allocate(100000);
+        resource.deallocate(p, 100000);
+    }
+}
+
+int main() {
+    return kls::test::run([] {
+        large_classes_do_not_overlap(pool_resource());
+        large_classes_do_not_overlap(per_processor_pool_resource());
+        nodes_are_reused(pool_resource());
+        batches_round_trip(pool_resource());
+        batches_round_trip(per_processor_pool_resource());
+        unsynchronized_resource();
+    });
+}
@@ -0,0 +1,92 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <bit>
+#include <cstdint>
+#include "Check.h"
+#include "kls/essential/Schema.h"
+
+using namespace kls;
+using namespace kls::essential;
+
+namespace {
+    struct Record {
+        uint32_t a, b, c, d;
+    };
+
+    enum class Kind : int32_t { seven = 7 };
+
+    struct Tagged {
+        Kind kind;
+        int32_t count;
+    };
+
+    using Reordered = Schema<Field<&Record::a>, Field<&Record::c>, Field<&Record::b>, Field<&Record::d>>;
+    using Converted = Schema<Field<&Tagged::kind, float>, Field<&Tagged::count>>;
+
+    static_assert(!Field<&Tagged::kind, float>::raw<std::endian::native> && Field<&Tagged::kind>::raw<std::endian::native>);
+
+    template<std::endian E>
+    uint32_t load32(const char *p) noexcept {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) {
+            const auto byte = uint32_t(static_cast<unsigned char>(p[E == std::endian::little ? 3 - i : i]));
+            v = v << 8 | byte;
+        }
+        return v;
+    }
+
+    // fields are laid out in schema order, not member order
+    template<std::endian E>
+    void reordered_round_trip() {
+        const Record in{1, 2, 3, 0x01020304};
+        char buffer[16];
+        Reordered::encode<E>(Span<char, 16>(buffer), in);
+        KLS_CHECK(load32<E>(buffer) == 1 && load32<E>(buffer + 4) == 3 && load32<E>(buffer + 8) == 2);
+        KLS_CHECK(load32<E>(buffer + 12) == 0x01020304);
+        Record out{};
+        Reordered::decode<E>(Span<char, 16>(buffer), out);
+        KLS_CHECK(out.a == 1 && out.b == 2 && out.c == 3 && out.d == 0x01020304);
+    }
+
+    // a field whose wire type differs from its member type is converted on both ends
+    template<std::endian E>
+    void converted_round_trip() {
+        const Tagged in{Kind::seven, -9};
+        char buffer[8];
+        Converted::encode<E>(Span<char, 8>(buffer), in);
+        const auto bits = load32<E>(buffer);
+        KLS_CHECK(std::bit_cast<float>(bits) == 7.0f);
+        Tagged out{};
+        Converted::decode<E>(Span<char, 8>(buffer), out);
+        KLS_CHECK(out.kind == Kind::seven && out.count == -9);
+    }
+}
+
+int main() {
+    return test::run([] {
+        reordered_round_trip<std::endian::little>();
+        reordered_round_trip<std::endian::big>();
+        converted_round_trip<std::endian::little>();
+        converted_round_trip<std::endian::big>();
+    });
+}
@@ -0,0 +1,116 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <random>
+#include <vector>
+#include <cstdint>
+#include "Check.h"
+#include "kls/Simd.h"
+
+using namespace kls;
+
+namespace {
+    constexpr simd::Level levels[] = {simd::Level::Scalar, simd::Level::SSE2, simd::Level::AVX2, simd::Level::AVX512};
+
+    // runs every kernel over all lengths up to a few vectors and at every misalignment within a vector, the results
+    // of each level are appended to out and compared with the scalar level by the caller
+    template<class T>
+    std::vector<double> run_kernels(const std::vector<T> &source) {
+        std::vector<double> out;
+        for (size_t offset = 0; offset < 8; ++offset) {
+            for (size_t size = 0; offset + size <= source.size() && size < 300; ++size) {
+                std::vector<T> data(source.begin() + ptrdiff_t(offset), source.begin() + ptrdiff_t(offset + size));
+                const Span<T> span(data.data(), data.size());
+                const auto probe = size ? data[size / 2] : T(1);
+                out.push_back(double(simd::find(span, probe)));
+                out.push_back(double(simd::find_first_not(span, size ? data[0] : T(0))));
+                out.push_back(double(simd::count(span, probe)));
+                out.push_back(double(simd::min(span)));
+                out.push_back(double(simd::max(span)));
+                out.push_back(double(simd::sum(span)));
+                auto copy = data;
+                out.push_back(double(simd::equal(span, Span<T>(copy.data(), copy.size()))));
+                if (size) {
+                    copy[size - 1] = T(copy[size - 1] + T(1));
+                    out.push_back(double(simd::equal(span, Span<T>(copy.data(), copy.size()))));
+                }
+                simd::fill(Span<T>(copy.data(), copy.size()), T(3));
+                size_t filled = 0;
+                for (const auto x: copy) filled += x == T(3);
+                out.push_back(double(filled == size));
+            }
+        }
+        return out;
+    }
+
+    // values are small integers so that the reordered floating point sums stay exact
+    template<class T>
+    std::vector<T> make_data(std::mt19937 &rng) {
+        std::uniform_int_distribution<int> dist(std::is_signed_v<T> ? -50 : 0, 50);
+        std::vector<T> result(320);
+        for (auto &x: result) x = T(dist(rng));
+        return result;
+    }
+
+    template<class T>
+    void check_levels(std::mt19937 &rng) {
+        const auto data = make_data<T>(rng);
+        simd::set_level(simd::Level::Scalar);
+        const auto expected = run_kernels(data);
+        for (const auto level: levels) {
+            if (level > simd::supported_level()) break;
+            simd::set_level(level);
+            KLS_CHECK(run_kernels(data) == expected);
+        }
+        simd::set_level(simd::supported_level());
+    }
+
+    // the scalar level itself against plain loops
+    void check_scalar() {
+        simd::set_level(simd::Level::Scalar);
+        std::vector<int32_t> data{5, 3, 9, 3, -2, 7};
+        const Span<int32_t> span(data.data(), data.size());
+        KLS_CHECK(simd::find(span, 3) == 1 && simd::find(span, 4) == 6);
+        KLS_CHECK(simd::find_first_not(span, 5) == 1 && simd::count(span, 3) == 2);
+        KLS_CHECK(simd::min(span) == -2 && simd::max(span) == 9 && simd::sum(span) == 25);
+        KLS_CHECK(simd::min(Span<int32_t>(data.data(), 0)) == INT32_MAX);
+        simd::set_level(simd::supported_level());
+    }
+}
+
+int main() {
+    return test::run([] {
+        std::mt19937 rng(42);
+        check_scalar();
+        check_levels<int8_t>(rng);
+        check_levels<uint8_t>(rng);
+        check_levels<int16_t>(rng);
+        check_levels<uint16_t>(rng);
+        check_levels<int32_t>(rng);
+        check_levels<uint32_t>(rng);
+        check_levels<int64_t>(rng);
+        check_levels<uint64_t>(rng);
+        check_levels<float>(rng);
+        check_levels<double>(rng);
+        KLS_CHECK(simd::set_level(simd::Level::AVX512) == simd::supported_level());
+    });
+}
@@ -0,0 +1,90 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "Check.h"
+#include "kls/SlotMap.h"
+
+using namespace kls;
+
+namespace {
+    struct Checked {
+        explicit Checked(int value): value(value) { if (value < 0) throw std::invalid_argument("negative"); }
+
+        int value;
+    };
+
+    // an erased slot is reused under the next generation, keys of the old entry stay stale
+    void generations_are_reused() {
+        SlotMap<std::string> map;
+        const auto a = map.insert("a");
+        const auto b = map.insert("b");
+        KLS_CHECK(map.erase(a));
+        KLS_CHECK(!map.erase(a));
+        KLS_CHECK(!map.contains(a) && map.find(a) == nullptr);
+        const auto c = map.insert("c");
+        KLS_CHECK(c.index == a.index && c.generation == a.generation + 1);
+        KLS_CHECK(!map.contains(a) && *map.find(c) == "c" && map[b] == "b");
+        KLS_CHECK(!map.contains(SlotKey{}));
+        map.clear();
+        KLS_CHECK(map.empty() && !map.contains(b) && !map.contains(c));
+        const auto d = map.insert("d");
+        KLS_CHECK(map.size() == 1 && map[d] == "d" && d != b && d != c);
+    }
+
+    // erase keeps the values dense and the keys pointing at the moved values
+    void erase_keeps_keys_valid() {
+        SlotMap<int> map;
+        std::vector<SlotKey> keys;
+        for (int i = 0; i < 1000; ++i) keys.push_back(map.insert(i));
+        for (int i = 0; i < 1000; i += 3) KLS_CHECK(map.erase(keys[size_t(i)]));
+        for (int i = 0; i < 1000; ++i) {
+            const auto value = map.find(keys[size_t(i)]);
+            KLS_CHECK(i % 3 == 0 ? value == nullptr : value && *value == i);
+        }
+        KLS_CHECK(map.size() == 666 && map.values().size() == 666);
+        for (size_t position = 0; position < map.size(); ++position)
+            KLS_CHECK(map[map.key_at(position)] == map.begin()[position]);
+    }
+
+    // a failed emplace gives its slot back without leaving a live key behind
+    void failed_emplace_releases_slot() {
+        SlotMap<Checked> map;
+        bool thrown = false;
+        try { (void) map.emplace(-1); }
+        catch (const std::invalid_argument &) { thrown = true; }
+        KLS_CHECK(thrown && map.empty());
+        KLS_CHECK(!map.contains(SlotKey{0, 0}));
+        const auto key = map.emplace(3);
+        KLS_CHECK(key.index == 0 && key.generation == 1 && map.find(key)->value == 3);
+    }
+}
+
+int main() {
+    return test::run([] {
+        generations_are_reused();
+        erase_keeps_keys_valid();
+        failed_emplace_releases_slot();
+    });
+}
@@ -0,0 +1,113 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <string>
+#include <thread>
+#include <vector>
+#include "Check.h"
+#include "kls/essential/SpanChain.h"
+
+// vectored I/O is only provided on POSIX systems
+#ifndef KLS_SYS_NTOS
+#include <unistd.h>
+
+using namespace kls;
+using namespace kls::essential;
+
+namespace {
+    struct Pieces {
+        std::vector<std::string> text;
+        SpanChain chain;
+
+        explicit Pieces(size_t count) {
+            for (size_t i = 0; i < count; ++i) text.push_back(std::to_string(i * 7919) + ",");
+            for (auto &piece: text) chain.append(Span<>(piece.data(), piece.size()));
+        }
+
+        std::string flat() const {
+            std::string result(chain.size(), '\0');
+            chain.copy_to(Span<>(result.data(), result.size()));
+            return result;
+        }
+    };
+
+    std::string join(const iovec *vectors, size_t count) {
+        std::string result;
+        for (size_t i = 0; i < count; ++i) result.append(static_cast<const char *>(vectors[i].iov_base), vectors[i].iov_len);
+        return result;
+    }
+
+    // a cursor advanced step by step describes the same bytes as a skip counted from the start
+    void cursor_matches_skip() {
+        const Pieces pieces(40);
+        const auto flat = pieces.flat();
+        iovec by_skip[64], by_cursor[64];
+        SpanChain::Cursor cursor{};
+        for (size_t skip = 0; skip <= flat.size(); ++skip) {
+            const auto a = pieces.chain.to_iovec(Span<iovec>(by_skip, 64), skip);
+            const auto b = pieces.chain.to_iovec(Span<iovec>(by_cursor, 64), cursor);
+            KLS_CHECK(a == b && join(by_skip, a) == flat.substr(skip) && join(by_cursor, b) == flat.substr(skip));
+            cursor = pieces.chain.advance(cursor, 1);
+        }
+        KLS_CHECK(cursor.segment == pieces.chain.count() && cursor.offset == 0);
+    }
+
+    // more segments than one writev call takes, drained by a reader so that writes may be partial
+    void writev_through_pipe() {
+        const Pieces pieces(1000);
+        int fds[2];
+        KLS_CHECK(pipe(fds) == 0);
+        std::string received;
+        std::thread reader([&] {
+            char buffer[777];
+            for (ptrdiff_t n; (n = read(fds[0], buffer, sizeof(buffer))) > 0;) received.append(buffer, size_t(n));
+        });
+        KLS_CHECK(writev(fds[1], pieces.chain) == ptrdiff_t(pieces.chain.size()));
+        close(fds[1]);
+        reader.join();
+        close(fds[0]);
+        KLS_CHECK(received == pieces.flat());
+    }
+
+    void readv_fills_segments() {
+        char first[10], second[10];
+        const SpanChain chain{Span<>(first, 10), Span<>(second, 10)};
+        int fds[2];
+        KLS_CHECK(pipe(fds) == 0);
+        KLS_CHECK(write(fds[1], "abcdefghijklmno", 15) == 15);
+        close(fds[1]);
+        KLS_CHECK(readv(fds[0], chain) == 15);
+        close(fds[0]);
+        KLS_CHECK(std::string(first, 10) == "abcdefghij" && std::string(second, 5) == "klmno");
+    }
+}
+
+int main() {
+    return test::run([] {
+        cursor_matches_skip();
+        writev_through_pipe();
+        readv_fills_segments();
+    });
+}
+#else
+int main() { return 0; }
+#endif
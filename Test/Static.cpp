@@ -0,0 +1,60 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <vector>
+#include "Check.h"
+#include "kls/pmr/Pool.h"
+#include "kls/pmr/Stats.h"
+#include "kls/pmr/Static.h"
+
+using namespace kls::pmr;
+
+namespace {
+    // a container built before the default resource is replaced frees into the resource it allocated from
+    void default_allocator_keeps_its_resource() {
+        StatsResource before("test.before", pool_resource()), after("test.after");
+        set_default_resource(&before);
+        std::vector<int, default_allocator<int>> v(100, 1);
+        set_default_resource(&after);
+        v.resize(1000, 2);
+        std::vector<int, default_allocator<int>> w(10, 3);
+        KLS_CHECK(after.stats().allocations == 1);
+        v.clear();
+        v.shrink_to_fit();
+        set_default_resource(nullptr);
+        KLS_CHECK(before.stats().live_bytes == 0 && before.stats().allocations == 2);
+        KLS_CHECK(after.stats().live_bytes == 40);
+    }
+
+    void new_delete_allocator_round_trip() {
+        std::vector<double, new_delete_allocator<double>> v{};
+        for (int i = 0; i < 1000; ++i) v.push_back(i);
+        KLS_CHECK(v[999] == 999.0);
+    }
+}
+
+int main() {
+    return kls::test::run([] {
+        default_allocator_keeps_its_resource();
+        new_delete_allocator_round_trip();
+    });
+}
@@ -0,0 +1,91 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <thread>
+#include <vector>
+#include "Check.h"
+#include "kls/pmr/Stats.h"
+#include "kls/pmr/Pool.h"
+
+using namespace kls::pmr;
+
+namespace {
+    void counts_requests() {
+        StatsResource stats("test.counts", pool_resource());
+        const auto a = stats.allocate(24, 8);
+        const auto b = stats.allocate(3000, 16);
+        auto result = stats.stats();
+        KLS_CHECK(result.allocations == 2 && result.deallocations == 0);
+        KLS_CHECK(result.live_bytes == 3024 && result.peak_bytes >= 3024);
+        KLS_CHECK(result.sizes[5] == 1 && result.sizes[12] == 1);
+        KLS_CHECK(result.alignments[3] == 1 && result.alignments[4] == 1);
+        stats.deallocate(a, 24, 8);
+        stats.deallocate(b, 3000, 16);
+        result = stats.stats();
+        KLS_CHECK(result.deallocations == 2 && result.live_bytes == 0 && result.peak_bytes >= 3024);
+    }
+
+    void at_least_reports_the_request() {
+        StatsResource stats("test.at_least", pool_resource());
+        const auto result = stats.allocate_at_least(20);
+        KLS_CHECK(result.count == 20 && stats.stats().live_bytes == 20);
+        stats.deallocate(result.ptr, result.count);
+        KLS_CHECK(stats.stats().live_bytes == 0);
+    }
+
+    void peak_follows_large_steps() {
+        StatsResource stats("test.peak");
+        std::vector<void *> blocks;
+        for (int i = 0; i < 16; ++i) blocks.push_back(stats.allocate(1 << 20));
+        for (const auto p: blocks) stats.deallocate(p, 1 << 20);
+        const auto result = stats.stats();
+        KLS_CHECK(result.live_bytes == 0);
+        KLS_CHECK(result.peak_bytes > (16 << 20) - (64 << 10) && result.peak_bytes <= (16 << 20));
+    }
+
+    // memory allocated on one thread and freed on another still adds up to zero
+    void live_bytes_across_threads() {
+        StatsResource stats("test.threads", pool_resource());
+        std::vector<void *> blocks(4000);
+        std::thread producer([&] { for (auto &p: blocks) p = stats.allocate(48); });
+        producer.join();
+        std::vector<std::thread> consumers;
+        for (size_t t = 0; t < 4; ++t) {
+            consumers.emplace_back([&, t] {
+                for (auto i = t; i < blocks.size(); i += 4) stats.deallocate(blocks[i], 48);
+            });
+        }
+        for (auto &t: consumers) t.join();
+        const auto result = stats.stats();
+        KLS_CHECK(result.allocations == 4000 && result.deallocations == 4000);
+        KLS_CHECK(result.live_bytes == 0 && result.peak_bytes >= 4000 * 48 - (64 << 10));
+    }
+}
+
+int main() {
+    return kls::test::run([] {
+        counts_requests();
+        at_least_reports_the_request();
+        peak_follows_large_steps();
+        live_bytes_across_threads();
+    });
+}
@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <thread>
+#include <vector>
+#include <cstring>
+#include "Check.h"
+#include "kls/temp/Temp.h"
+
+using namespace kls;
+
+namespace {
+    bool aligned(const void *p, size_t align) noexcept { return reinterpret_cast<uintptr_t>(p) % align == 0; }
+
+    // allocations from many blocks stay intact and aligned, and are freed in any order
+    void allocations_are_disjoint() {
+        struct allocation {
+            void *p;
+            size_t size;
+        };
+        std::vector<allocation> live;
+        for (size_t i = 0; i < 20000; ++i) {
+            const auto size = 1 + (i * 37) % 3000;
+            const auto p = temp::allocate(size);
+            KLS_CHECK(aligned(p, alignof(std::max_align_t)));
+            std::memset(p, int(i & 0xFF), size);
+            live.push_back({p, size});
+        }
+        for (size_t i = 0; i < live.size(); ++i) {
+            const auto bytes = static_cast<const unsigned char *>(live[i].p);
+            KLS_CHECK(bytes[0] == (i & 0xFF) && bytes[live[i].size - 1] == (i & 0xFF));
+        }
+        for (size_t i = 0; i < live.size(); i += 2) temp::deallocate(live[i].p, live[i].size);
+        for (size_t i = 1; i < live.size(); i += 2) temp::deallocate(live[i].p, live[i].size);
+    }
+
+    void large_and_overaligned() {
+        const auto big = temp::allocate(1 << 20);
+        std::memset(big, 1, 1 << 20);
+        temp::deallocate(big, 1 << 20);
+        const auto wide = temp::allocate(64, 256);
+        KLS_CHECK(aligned(wide, 256));
+        temp::deallocate(wide, 64, 256);
+    }
+
+    void resource_entry_points() {
+        const auto resource = temp::resource();
+        const auto result = resource->allocate_at_least(100);
+        KLS_CHECK(result.count >= 100);
+        KLS_CHECK(resource->try_expand(result.ptr, result.count, result.count + 512));
+        resource->deallocate(result.ptr, result.count + 512);
+        std::vector<void *> batch(5000);
+        resource->allocate_batch(Span<void *>(batch), 96);
+        for (const auto p: batch) std::memset(p, 0xAB, 96);
+        resource->deallocate_batch(Span<void *>(batch), 96);
+    }
+
+    // memory handed to another thread is freed there
+    void freed_on_another_thread() {
+        std::vector<void *> blocks;
+        for (size_t i = 0; i < 10000; ++i) blocks.push_back(temp::allocate(512));
+        std::thread([&] { for (const auto p: blocks) temp::deallocate(p, 512); }).join();
+    }
+
+    void containers() {
+        std::vector<int, temp::static_allocator<int>> v;
+        for (int i = 0; i < 100000; ++i) v.push_back(i);
+        KLS_CHECK(v[99999] == 99999);
+        std::vector<int, temp::allocator<int>> w(v.begin(), v.end());
+        KLS_CHECK(w.size() == v.size() && w[500] == 500);
+        const auto p = temp::make_unique<int[]>(10);
+        KLS_CHECK(p[9] == 0);
+    }
+}
+
+int main() {
+    return test::run([] {
+        allocations_are_disjoint();
+        large_and_overaligned();
+        resource_entry_points();
+        freed_on_another_thread();
+        containers();
+    });
+}
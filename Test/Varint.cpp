@@ -0,0 +1,127 @@
+/*
+* Copyright (c) 2022 DWVoid and Infinideastudio Team
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <random>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <climits>
+#include "Check.h"
+#include "kls/Simd.h"
+#include "kls/essential/Unsafe.h"
+
+using namespace kls;
+using namespace kls::essential;
+
+namespace {
+    using Writer = SpanWriter<std::endian::little>;
+    using Reader = SpanReader<std::endian::little>;
+
+    static_assert(zigzag_encode<int64_t>(-1) == 1 && zigzag_encode<int64_t>(1) == 2);
+    static_assert(zigzag_decode<uint64_t>(3) == -2 && zigzag_encode<int32_t>(INT32_MIN) == UINT32_MAX);
+    static_assert(varint_size(0) == 1 && varint_size(127) == 1 && varint_size(128) == 2);
+    static_assert(varint_size(UINT64_MAX) == max_varint_size);
+
+    void round_trip() {
+        constexpr uint64_t values[] = {0, 1, 127, 128, 300, 1ull << 35, UINT64_MAX};
+        std::vector<char> buffer(1024);
+        Writer writer(Span<>(buffer.data(), buffer.size()));
+        for (const auto v: values) writer.put_varint(v);
+        writer.put_svarint(-5);
+        writer.put_svarint(INT64_MIN);
+        writer.put_string("hello");
+        Reader reader(writer.written());
+        for (const auto v: values) {
+            uint64_t x = 0;
+            KLS_CHECK(reader.get_varint(x) && x == v);
+        }
+        int64_t a = 0, b = 0;
+        KLS_CHECK(reader.get_svarint(a) && a == -5 && reader.get_svarint(b) && b == INT64_MIN);
+        std::string_view text;
+        KLS_CHECK(reader.get_string(text) && text == "hello");
+        uint64_t x = 0;
+        KLS_CHECK(!reader.get_varint(x) && reader.remaining() == 0);
+    }
+
+    // malformed and truncated input fails without moving the reader
+    void rejects_bad_input() {
+        unsigned char endless[11];
+        for (auto &b: endless) b = 0xFF;
+        uint64_t x = 0;
+        Reader overlong(Span<>(endless, sizeof(endless)));
+        KLS_CHECK(!overlong.get_varint(x) && overlong.offset() == 0);
+        const unsigned char truncated[2] = {0x05, 'a'};
+        Span<char> out{static_cast<char *>(nullptr), 0};
+        Reader prefixed(Span<>(truncated, sizeof(truncated)));
+        KLS_CHECK(!prefixed.get_prefixed(out) && prefixed.offset() == 0);
+        // five bytes that do not fit into 32 bits
+        const unsigned char wide[5] = {0xFF, 0xFF, 0xFF, 0xFF, 0x1F};
+        uint32_t value = 0;
+        Reader bulk(Span<>(wide, sizeof(wide)));
+        KLS_CHECK(!bulk.get_varints(Span<uint32_t>(&value, 1)));
+    }
+
+    // the bulk decoder gives the same values at every level, for runs of short, long and mixed encodings
+    void bulk_decode_levels_agree() {
+        std::mt19937 random{5};
+        const simd::Level levels[] = {simd::Level::Scalar, simd::supported_level()};
+        for (int shape = 0; shape < 4; ++shape) {
+            std::vector<uint32_t> values(10007);
+            for (auto &v: values) {
+                switch (shape) {
+                    case 0: v = random() % 128; break;
+                    case 1: v = 128 + random() % 16000; break;
+                    case 2: v = random() % 4 ? random() % 128 : uint32_t(random()); break;
+                    default: v = uint32_t(random()); break;
+                }
+            }
+            std::vector<char> encoded(values.size() * 5);
+            Writer writer(Span<>(encoded.data(), encoded.size()));
+            writer.put_varints(Span<const uint32_t>(values.data(), values.size()));
+            for (const auto level: levels) {
+                simd::set_level(level);
+                for (size_t count = 0; count < 100; ++count) {
+                    std::vector<uint32_t> decoded(count);
+                    Reader reader(writer.written());
+                    KLS_CHECK(reader.get_varints(Span<uint32_t>(decoded.data(), count)));
+                    KLS_CHECK(std::equal(decoded.begin(), decoded.end(), values.begin()));
+                }
+                std::vector<uint32_t> decoded(values.size());
+                Reader reader(writer.written());
+                KLS_CHECK(reader.get_varints(Span<uint32_t>(decoded.data(), decoded.size())));
+                KLS_CHECK(reader.remaining() == 0 && decoded == values);
+                Reader truncated(writer.written().keep_front(writer.offset() - 1));
+                KLS_CHECK(!truncated.get_varints(Span<uint32_t>(decoded.data(), decoded.size())));
+                KLS_CHECK(truncated.offset() == 0);
+            }
+        }
+        simd::set_level(simd::supported_level());
+    }
+}
+
+int main() {
+    return test::run([] {
+        round_trip();
+        rejects_bad_input();
+        bulk_decode_levels_agree();
+    });
+}